@@ -0,0 +1,59 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: ballAssignment.h
+    DESCRIPTION: Optimal assignment between tracked balls and detected balls, with a spatial grid to find the candidate pairs.
+
+    CLASSES:
+    - struct assignmentPair: A track matched with a detection, and their distance.
+    - class spatialGrid: Uniform grid of points, to find the points near a position without comparing with all of them.
+
+    FUNCTIONS:
+    - std::vector<assignmentPair> assignDetections(...): Matches tracks and detections minimizing the total distance, among the pairs closer than the gate of the detection. Every track and every detection is used at most once.
+    - std::vector<assignmentPair> assignDetections(..., excluded): Same assignment, leaving out the excluded tracks (e.g. pocketed balls). The result refers to the indices of all the tracks.
+
+    NOTES:
+    - Only the pairs within the gate are considered (found through the grid). They are split into groups that share no track and no detection, and every group is solved on its own with the Hungarian algorithm: the cost follows the size of the groups, usually one or two balls, not the number of balls on the table.
+    - The gated-out pairs of a group get a cost higher than any valid pair, so the assignment first uses as many valid pairs as possible, then minimizes their total distance.
+    - The result does not depend on the order of the inputs except for exact ties, and it is sorted by track.
+    - The grid has at most `MAX_SIDE` cells per side: when the points are far apart the cells get larger, so a single outlier cannot make the grid huge.
+*/
+
+#ifndef BALLASSIGNMENT_INCLUDED
+#define BALLASSIGNMENT_INCLUDED
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+struct assignmentPair{
+
+    size_t track;
+    size_t detection;
+    double distance;
+
+};
+
+class spatialGrid{
+
+private:
+
+    static constexpr int MAX_SIDE = 256;    //max number of cells per side
+
+    double cell;
+    cv::Point2f origin;
+    int cols, rows;
+    std::vector<std::vector<size_t>> cells;
+    std::vector<cv::Point2f> points;
+
+public:
+
+    explicit spatialGrid(const std::vector<cv::Point2f>& points, double cell_size);
+
+    void query(const cv::Point2f& position, double radius, std::vector<size_t>& found) const;
+
+};
+
+std::vector<assignmentPair> assignDetections(const std::vector<cv::Point2f>& tracks, const std::vector<cv::Point2f>& detections, const std::vector<double>& gates);
+std::vector<assignmentPair> assignDetections(const std::vector<cv::Point2f>& tracks, const std::vector<cv::Point2f>& detections, const std::vector<double>& gates, const std::vector<bool>& excluded);
+
+#endif
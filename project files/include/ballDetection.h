@@ -9,19 +9,35 @@
 
     MAIN FUNCTIONS:
     - ballDetector(): Constructor to initialize the ballDetector object.
-    - void detectBalls(...): Handles the detection and calls the other functions.
-    - void applyColourDetection(...): Performs detection using Hough Transform on colour masks.
-    - void selectBalls(...): Select just the acceptable balls using colour thresholding masks.
-    - BallPattern analyzeBallPattern(...): Analyzes the ball pattern based on its appearance.
+    - void detectBalls(...): Handles the detection and calls the other functions. The frame and its Lab/gray conversions come from the frame context.
+    - bool cropTable(...): Crop of the table with its margin, outside mask and gray crop of the frame. False on invalid inputs.
+    - void convertTable(...): Masked BGR (`table_roi`) and Lab (`table_lab`) crops of the frame.
+    - void applyColourDetection(...): Performs detection using Hough Transform (or the distance transform detector, if `distance_circles` is set) on colour masks, starting from the Lab image of the table.
+    - void set_thread_budget(...): Sets how many threads run the detection (1 = serial on the whole table, otherwise tiled).
+    - bool detectBallsIncremental(...): Incremental mode of `detectBalls`: keeps the balls of the last detection whose box did not change and searches again only the changed regions of the table. Returns false when too much of the table changed.
+    - void finishDetection(...): Common end of both modes: back to frame coordinates, classification, metric matrices and state for the next incremental detection.
+    - void findCircles(...): Circle search on a colour mask with the selected detector (HoughCircles or distance transform).
+    - void set_known_balls(...): Sets the balls whose class is already known (e.g. confident tracks): a candidate on one of them takes its pattern instead of being analyzed again. Empty vectors turn it off.
+    - void print_stats(): Prints how many detections were full or incremental and the share of the table searched (incremental mode only).
+    - void tiledColourDetection(...): Tiled mode of `applyColourDetection`: thresholding and circle search on overlapping tiles of the table in parallel, then merge of the circles.
+    - void findCirclesDistance(...): Ball-specific circle detector: distance transform of the pixels that are not cloth, local maxima with a value in the radius range, check of the cloth around each maximum and suppression of the maxima closer than `min_circle_distance`.
+    - void selectBalls(...): Select just the acceptable balls using colour thresholding masks. The statistics of each candidate are computed on the bounding box of its circle only.
+    - BallPattern analyzeBallPattern(...): Analyzes the ball pattern based on its appearance, on the grayscale patch of the ball.
     - void classifyBalls(...): Classifies each ball given its colour and pattern analytics.
-    - void detectBallsFinalFrame(...): Detects balls in the final frame and matches with tracker centers.
     - void saveInfo(...): Stores important information about each single selected ball.
 
     ADDITIONAL FUNCTIONS: 
-    - enhanceContrast(...): Enhances the contrast of the input image using CLAHE (Contrast Limited Adaptive Histogram Equalization) in the LAB color space. Improves the visibility of features in the image.
+    - enhanceContrast(...): Enhances the contrast of the input image, given in the LAB color space, using CLAHE (Contrast Limited Adaptive Histogram Equalization). Improves the visibility of features in the image. The CLAHE object is owned by the detector and reused.
     - detectedBallsData(...): Constructs a matrix with information about detected balls, including their bounding boxes and IDs.
     - createLabeledImage(...): Creates a labeled image that visualizes detected balls with their corresponding IDs.
 
+    NOTES:
+    - Every step works on the bounding box of the table (`crop`) only, the results are brought back to frame coordinates at the end.
+    - The sizes in pixels (radius range, crop margin, tile overlap, corner and matching distances) are given for a table whose long side is `REFERENCE_TABLE_SIZE` pixels, the size of the dataset tables, and scaled with the table found in the frame, so the detection behaves the same at any resolution.
+    - The distance transform detector returns its candidates in the same `Vec3f` format as HoughCircles (center and radius, crop coordinates), so the selection and the classification run unchanged on them. The candidates themselves differ from the Hough ones. On the flat cloth a ball is a hole of the colour mask whose distance transform peaks at its center with the value of its radius: there is no accumulator and the cost is two passes over the crop. The circle benchmark in `benchmark.h` measures the difference.
+    - In tiled mode the crop is split into `TILE_SIZE` cores, each one searched with twice the max radius of context on every side (more than a ball diameter), so every ball is whole in the tile that owns its center. CLAHE still runs once on the whole crop (its result depends on the neighbouring tiles of its own grid), and the selection and classification run on the merged circles.
+    - In incremental mode the gray crop is compared with the one of the last detection on a grid of `CHANGE_BLOCK` blocks. The changed blocks, plus the blocks of the balls whose box changed, are grouped into regions and searched with the same context as the tiles (CLAHE on the region only, hue of the last full detection). The cost follows the motion on the table. A full detection runs when the table moves or more than `MAX_CHANGED_FRACTION` of it changed. `table_roi` and `table_lab` are refreshed by the full detections only.
+
     EXAMPLES:
     - Input: A frame from a video feed with balls visible.
     - Output: A frame with detected circles overlaid, showing both the detected circles and their classes.
@@ -32,9 +48,27 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 
-#ifndef BALLDDETECTION_INCLUDED
+#include "frameContext.h"
+#include "workerPool.h"
+
+#include <memory>
+
+#ifndef BALLDETECTION_INCLUDED
   #define BALLDETECTION_INCLUDED
 
+  // Buffers of a distance transform search
+  struct distanceBuffers {
+    cv::Mat holes, distance, distance_max;
+  };
+
+  // Counters of the detection modes
+  struct detectionStats {
+    long long full = 0;
+    long long incremental = 0;
+    long long searched_pixels = 0;    //crop pixels searched, over all detections
+    long long crop_pixels = 0;        //crop pixels, over all detections
+  };
+
   struct BallPattern {
     double whitePercentage;
     double blackPercentage;
@@ -50,25 +84,76 @@
     private: 
 
     std::vector<cv::Rect> bboxes;
+    cv::Ptr<cv::CLAHE> clahe;   //reused on every frame
+    cv::Rect crop;              //bounding box of the table (plus margin) the detection works on
+    cv::Size frame_size;
+    int min_circle_distance;    //HoughCircles minDist, from the rows of the whole frame
+    double table_scale;         //long side of the table / REFERENCE_TABLE_SIZE
+    int min_radius, max_radius; //radius range of the circle detectors, at the scale of the table
+    cv::Mat gray_roi;           //grayscale of table_roi, once per frame
+    cv::Mat table_lab;          //Lab of table_roi
+    cv::Mat outside_mask;       //crop pixels outside of the table
+    distanceBuffers buffers;    //distance transform detector buffers
+
+    std::shared_ptr<workerPool> pool;                   //nullptr = serial, untiled
+    std::vector<cv::Mat> tile_masks;                    //per tile, tiled mode
+    std::vector<std::vector<cv::Vec3f>> tile_circles;
+    std::vector<distanceBuffers> tile_buffers;
+
+    int cloth_hue;                          //hue of the cloth, from the last full detection
+    cv::Mat colour_mask;                    //colour mask of the crop, kept between detections
+    bool has_previous;                      //incremental mode state
+    cv::Mat previous_gray;
+    std::vector<BallPattern> previous_patterns;
+    cv::Mat change_mask, changed_blocks, labels, region_stats, region_centroids;
+    cv::Mat region_lab, region_mask;
+    detectionStats stats;
+
+    std::vector<cv::Point2f> known_centers;     //frame coordinates
+    std::vector<BallPattern> known_patterns;
     
     public:
 
-    cv::Mat table_roi;
+    static constexpr double REFERENCE_TABLE_SIZE = 720.0;  //long side of the table the pixel sizes below are given for, px
+    static const int CROP_MARGIN = 16;  //> max Hough radius
+    static const int MIN_RADIUS = 5;    //radius range of both circle detectors
+    static const int MAX_RADIUS = 15;
+    static const int TILE_SIZE = 256;                   //side of the tile cores, tiled mode
+    static constexpr double CORNER_DISTANCE = 60.0;     //min distance of a ball from a table corner
+    static const int CHANGE_BLOCK = 32;                 //side of the change blocks, incremental mode
+    static const int CHANGE_THRESHOLD = 25;             //gray levels
+    static const int MIN_CHANGED_PIXELS = 8;            //per block (or per ball box) to count as changed
+    static constexpr double MAX_CHANGED_FRACTION = 0.5; //of the crop, above it a full detection runs
+
+    bool distance_circles;      //distance transform detector instead of HoughCircles
+    bool incremental;           //incremental detection from the results of the last one
+
+    cv::Mat table_roi;          //frame masked with the table, cropped to `crop`
     std::vector<cv::Point2f> centers;
     std::vector<cv::Rect> balls;
     std::vector<int> id_balls;
+    std::vector<BallPattern> patterns;          //pattern and class of every ball of the last detection
     cv::Mat bbox_data;
     cv::Mat classification_res;
 
 
     explicit ballDetector();
 
-    void detectBalls(const cv::Mat& currentFrame, const cv::Mat& ROI, const std::vector<cv::Point2f> table_corners);
-    void applyColourDetection(cv::Mat& frame, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles);
+    void detectBalls(frameContext& context, const cv::Mat& ROI, const std::vector<cv::Point2f> table_corners);
+    bool cropTable(frameContext& context, const cv::Mat& ROI);
+    void convertTable(frameContext& context, const cv::Mat& ROI);
+    void applyColourDetection(const cv::Mat& lab_frame, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles);
+    void set_thread_budget(int threads);
+    bool detectBallsIncremental(const cv::Mat& frame, const cv::Mat& ROI, const std::vector<cv::Point2f>& crop_corners, std::vector<BallPattern>& ballPatterns);
+    void finishDetection(const cv::Mat& ROI, std::vector<BallPattern>& ballPatterns);
+    void findCircles(const cv::Mat& mask, const cv::Mat& outside, std::vector<cv::Vec3f>& circles, distanceBuffers& buffers) const;
+    void set_known_balls(const std::vector<cv::Point2f>& centers, const std::vector<BallPattern>& patterns);
+    void print_stats() const;
+    void tiledColourDetection(const cv::Mat& edit, const cv::Rect& centerRect, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles);
+    void findCirclesDistance(const cv::Mat& colour_mask, const cv::Mat& outside, std::vector<cv::Vec3f>& circles, distanceBuffers& buffers) const;
     std::vector<BallPattern> selectBalls(const cv::Mat& ROI, const cv::Mat& mask, const std::vector<cv::Vec3f>& circle, const std::vector<cv::Point2f> table_corners);
-    BallPattern analyzeBallPattern(const cv::Mat& ballROI, const cv::Mat& circleMask);
+    BallPattern analyzeBallPattern(const cv::Mat& grayBall, const cv::Mat& circleMask);
     void classifyBalls(std::vector<BallPattern>& ballPatterns);
-    void detectBallsFinalFrame(const cv::Mat& frame, const cv::Mat& ROI, const std::vector<cv::Point2f>& trackerCenters, const std::vector<int>& trackerIDs, const std::vector<cv::Point2f>& table_corners);
     void saveInfo(const cv::Point center, const int radius);
 
   };
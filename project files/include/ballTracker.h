@@ -0,0 +1,93 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: ballTracker.h
+    DESCRIPTION: Defines the interface of a single-ball tracker and its backends.
+
+    CLASSES:
+    - enum trackerBackend: Available backends (CSRT, KCF, MOSSE, BALL).
+    - class ballTracker: Interface of a tracker following one ball.
+    - class opencvBallTracker: Backend wrapping an OpenCV tracker (CSRT, KCF, MOSSE).
+    - class velocityBallTracker: Purpose-built ball tracker: constant-velocity prediction plus a template search in a small window around the prediction.
+
+    MAIN FUNCTIONS:
+    - cv::Ptr<ballTracker> createBallTracker(...): Creates a tracker of the given backend.
+    - bool parseTrackerBackend(...): Converts a name (csrt, kcf, mosse, ball) to a backend.
+    - std::string trackerBackendName(...): Name of a backend.
+    - void init(...): Initializes the tracker on the bounding box of the ball.
+    - bool update(...): Finds the ball in the new frame. Returns false if the ball is lost.
+
+    NOTES:
+    - Balls are small, rigid and keep the same size along the clip, so the ball tracker does not estimate scale or learn a filter: it only keeps the appearance of the first frame.
+    - A tracker is used by one thread at a time, different trackers can be updated in parallel.
+*/
+
+#ifndef BALLTRACKER_INCLUDED
+#define BALLTRACKER_INCLUDED
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+#include <string>
+
+enum trackerBackend{
+    TRACKER_CSRT,
+    TRACKER_KCF,
+    TRACKER_MOSSE,
+    TRACKER_BALL
+};
+
+bool parseTrackerBackend(const std::string& name, trackerBackend& backend);
+std::string trackerBackendName(trackerBackend backend);
+
+class ballTracker{
+
+public:
+
+    virtual ~ballTracker() {}
+
+    virtual void init(const cv::Mat& frame, const cv::Rect& bbox) = 0;
+    virtual bool update(const cv::Mat& frame, cv::Rect& bbox) = 0;
+
+};
+
+class opencvBallTracker : public ballTracker{
+
+private:
+
+    cv::Ptr<cv::Tracker> tracker;
+
+public:
+
+    explicit opencvBallTracker(const cv::Ptr<cv::Tracker>& tracker);
+
+    void init(const cv::Mat& frame, const cv::Rect& bbox) override;
+    bool update(const cv::Mat& frame, cv::Rect& bbox) override;
+
+};
+
+class velocityBallTracker : public ballTracker{
+
+private:
+
+    cv::Mat templ;              //gray patch of the ball at init
+    cv::Point2f position;       //top-left corner of the last box
+    cv::Point2f velocity;       //px per frame
+    cv::Size size;
+    cv::Mat gray, response;     //buffers reused between frames
+
+public:
+
+    static const int SEARCH_MARGIN = 12;        //px around the predicted box
+    static constexpr double MIN_SCORE = 0.5;    //normalized correlation below which the ball is lost
+    static constexpr double VELOCITY_LR = 0.5;  //smoothing of the velocity estimate
+
+    explicit velocityBallTracker();
+
+    void init(const cv::Mat& frame, const cv::Rect& bbox) override;
+    bool update(const cv::Mat& frame, cv::Rect& bbox) override;
+
+};
+
+cv::Ptr<ballTracker> createBallTracker(trackerBackend backend);
+
+#endif
@@ -0,0 +1,41 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: batchRunner.h
+    DESCRIPTION: Functions to process all the clips of the dataset at the same time in a single process.
+
+    STRUCTS:
+    - struct clipReport: Results of a single clip (metrics, frames, timing, errors).
+
+    FUNCTIONS:
+    - std::vector<std::string> find_clips(...): Finds every clip folder of the dataset, i.e. every `<name>/<name>.mp4`.
+    - bool run_batch(...): Processes the clips headless on a pool of workers and prints one table with the results of every clip. Returns false if any clip failed.
+
+    NOTES:
+    - Every clip gets its own `videoHandler` (and so its own `frameHandler`), nothing is shared between the workers.
+    - With num_workers = 0 the pool is sized to the machine, but never larger than the number of clips.
+*/
+
+#ifndef BATCHRUNNER_INCLUDED
+#define BATCHRUNNER_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "processingOptions.h"
+
+struct clipReport{
+
+    std::string name;
+    double mAP;
+    double mIoU;
+    int frames;
+    double elapsed_s;
+    bool errors;
+
+};
+
+std::vector<std::string> find_clips(const std::string& dataset_path);
+bool run_batch(const std::vector<std::string>& clips, const processingOptions& options, int num_workers);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: benchmark.h
+    DESCRIPTION: Benchmarks of the processing stages on the clips of the dataset.
+
+    STRUCTS:
+    - struct trackerBenchmark: Result of a tracker backend on a single clip (speed, lost balls, end-position error).
+    - struct tableBenchmark: Time of the default and of the fused table segmentation on a single clip, and the difference between their outputs.
+    - struct circleBenchmark: Time of the ball detection with HoughCircles and with the distance transform detector on a single clip, and the groundtruth balls found by each one.
+
+    FUNCTIONS:
+    - std::vector<trackerBenchmark> benchmark_trackers(...): Runs every given tracker backend on every given clip and returns the results.
+    - void print_tracker_benchmark(...): Prints the results per clip and the average of every backend.
+    - std::vector<tableBenchmark> benchmark_table(...): Runs both table segmentation paths on the first frame of every given clip.
+    - void print_table_benchmark(...): Prints the results per clip and the overall speed-up.
+    - std::vector<circleBenchmark> benchmark_circles(...): Runs the ball detection with both circle detectors on the first frame of every given clip.
+    - void print_circle_benchmark(...): Prints the results per clip, the overall speed-up and recall.
+    - bool check_assignment(): Runs the detection-to-track assignment on small fixed cases (swapped detections, a track far away from the table, pocketed tracks) and prints the outcome of each one. False if any case fails.
+
+    NOTES:
+    - The trackers are initialized on the groundtruth boxes of the first frame, so the detection does not affect the comparison.
+    - Only initialization and update of the trackers are timed, decoding is excluded.
+    - The table benchmark repeats each path on the same frame and reports the mean time. The color conversion is done again at every repetition, as it would be on a new frame.
+    - The circle benchmark times the whole `detectBalls` (contrast enhancement, thresholding, circles, selection and classification) on the table found by the default path. A groundtruth ball is hit when a detected center falls in its box.
+    - The end-position error of a ball is the distance between its last tracked center and the nearest groundtruth center of the same class in the last frame. Lost balls are counted apart and not included in the error.
+*/
+
+#ifndef BENCHMARK_INCLUDED
+#define BENCHMARK_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "ballTracker.h"
+#include "processingOptions.h"
+
+struct trackerBenchmark{
+
+    std::string clip;
+    trackerBackend backend;
+    int frames;
+    int balls;
+    int lost;
+    double elapsed_s;
+    double end_error;   //mean, in px
+    bool errors;
+
+};
+
+struct tableBenchmark{
+
+    std::string clip;
+    double default_ms;      //mean time per frame
+    double fused_ms;
+    int diff_pixels;        //pixels where the two seg_masks differ
+    double iou;             //of the two seg_masks
+    double hull_distance;   //max distance of a hull vertex from the other hull, in px
+    bool errors;
+
+};
+
+struct circleBenchmark{
+
+    std::string clip;
+    double hough_ms;        //mean time per frame
+    double distance_ms;
+    int hough_balls;        //balls kept after the selection
+    int distance_balls;
+    int groundtruth;        //balls in the groundtruth of the first frame
+    int hough_hits;         //groundtruth balls containing a detected center
+    int distance_hits;
+    bool errors;
+
+};
+
+std::vector<trackerBenchmark> benchmark_trackers(const std::vector<std::string>& clips, const std::vector<trackerBackend>& backends, const processingOptions& options);
+void print_tracker_benchmark(const std::vector<trackerBenchmark>& results, const std::vector<trackerBackend>& backends);
+std::vector<tableBenchmark> benchmark_table(const std::vector<std::string>& clips, int repeats);
+void print_table_benchmark(const std::vector<tableBenchmark>& results);
+std::vector<circleBenchmark> benchmark_circles(const std::vector<std::string>& clips, int repeats);
+void print_circle_benchmark(const std::vector<circleBenchmark>& results);
+bool check_assignment();
+
+#endif
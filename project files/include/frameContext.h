@@ -0,0 +1,70 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: frameContext.h
+    DESCRIPTION: Defines the frameContext class, which holds the current frame and caches its color conversions for all the detection stages.
+
+    CLASS: frameContext
+
+    METHODS:
+    - frameContext(): Constructor to initialize an empty context.
+    - void reset(...): Starts a new frame. The cached conversions are dropped, their buffers are kept for the next frame.
+    - const cv::Mat& bgr(): The current frame.
+    - cv::Mat hsv(...) / lab(...) / gray(...): The frame (or a region of it) in HSV, Lab or grayscale. Converted on first use, then served from the cache.
+    - cv::Mat scaled(...): A region of the frame (BGR) resized by the given factor, e.g. the input of the trackers. Resized on first use, then served from the cache.
+    - void print_stats(): Prints the hits and misses of the cache since the start.
+
+    NOTES:
+    - A conversion covers only the region asked for: asking for a region already covered is a hit, otherwise the covered region is grown to include it (miss).
+    - The scaled copy is kept for one region and factor only: asking for another one resizes again (miss).
+    - The returned matrices are views on the cache: read-only for the stages, and valid until the next `reset`.
+    - The context is owned by `frameHandler` and used by one thread at a time.
+*/
+
+#ifndef FRAMECONTEXT_INCLUDED
+#define FRAMECONTEXT_INCLUDED
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+#include <iostream>
+
+// A color conversion of (part of) the frame
+struct colorPlane{
+
+    cv::Mat data;
+    cv::Rect area;      //region of the frame covered by data
+    bool valid;
+
+};
+
+class frameContext{
+
+private:
+
+    cv::Mat frame;
+    colorPlane hsv_plane;
+    colorPlane lab_plane;
+    colorPlane gray_plane;
+    colorPlane scaled_plane;
+    double scaled_factor;
+
+    cv::Mat convert(colorPlane& plane, int code, const cv::Rect& roi);
+
+public:
+
+    long long hits;
+    long long misses;
+
+    explicit frameContext();
+
+    void reset(const cv::Mat& frame);
+    const cv::Mat& bgr() const;
+    cv::Mat hsv(const cv::Rect& roi = cv::Rect());
+    cv::Mat lab(const cv::Rect& roi = cv::Rect());
+    cv::Mat gray(const cv::Rect& roi = cv::Rect());
+    cv::Mat scaled(const cv::Rect& roi, double scale);
+    void print_stats() const;
+
+};
+
+#endif
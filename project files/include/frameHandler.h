@@ -8,18 +8,34 @@
     - class frameHandler: Class for handling frames, including detecting tables and balls, initializing and updating trackers, and projecting ball trajectories.
 
     MAIN FUNCTIONS:
-    - frameHandler(): Constructor to initialize the frameHandler object.
-    - void detect_table(...): Detects the table in the given frame.
-    - void detect_balls(...): Detects balls in the given frame.
-    - void detect_balls_final(...): Detects balls in the final frame and matches them with tracker centers.
+    - frameHandler(...): Constructor to initialize the frameHandler object with the processing options.
+    - void begin_frame(...): Starts the analysis of a new frame: the detection steps below work on it, sharing its color conversions through the frame context.
+    - void detect_table(): Detects the table in the current frame. The detection runs again only if the camera moved since the last calibration.
+    - void detect_balls(): Detects balls in the current frame. With track classification the confident tracks are passed to the detector, which does not analyze their balls again.
     - void initializeTrackers(...): Initializes trackers for the detected balls.
     - void updateTrackers(...): Updates the trackers with the current frame.
-    - cv::Mat draw_frame(...): Draws the borders of the table on the given frame.
-    - void project(...): Projects the ball trajectories on the given frame.
+    - void print_tracker_stats(): Prints how many tracker updates the motion gating skipped, the final state of the tracks, the resyncs and restarted trackers, the hits of the color conversion cache, the share of incremental ball detections and the use of the track classifier.
+    - bool detect_rest(...): Feeds the frame to the shot segmentation. Returns true when the balls just came to rest after a shot.
+    - std::vector<int> center_ids(): Classes of the balls found by the trackers in the last frame, aligned with the tracker centers.
+    - cv::Mat tracker_input(...): Frame given to the trackers: the whole frame, or with `tracker_scale` < 1 the bounding box of the table (plus `TRACKER_MARGIN`) downscaled, cached in the frame context.
+    - void resync_trackers(...): Matches the last detection with the trackers (optimal assignment, pocketed balls excluded), restarts the matched trackers on the detected boxes and updates their classes (votes of the track classifier, if enabled). Unless all of them must be restarted (balls at rest), only the trackers that drifted more than `RESYNC_DRIFT` of the ball box, or are not active, are restarted.
+    - const shotSegmenter& finish_shots(...): Closes the shot timeline at the end of the clip and returns it.
+    - void reserve_history(...): Reserves the trajectory storage for the given number of frames.
+    - stageProfiler* stage_profiler(): Latency histograms of the stages of this run, also fed by the decode and encode steps of `videoHandler`.
+    - void skip_frames(...): Tells the trackers that the given number of frames were not analyzed (temporal stride).
+    - double max_displacement(): Largest move of a tracked ball between the last two analyzed frames, in px.
+    - bool save_trajectories(...): Writes the trajectory of every ball to a text file, one line per ball and frame, interpolated positions flagged.
+    - void save_state(...): Copies into a `renderState` everything the drawing steps need from the analysis of the current frame. Only the trajectory points added since the previous state with a homography are copied.
+    - void draw_frame(...): Draws the borders of the table on the given frame.
+    - cv::Mat project(...): Projects the ball trajectories on the given frame.
 
     ADDITIONAL FUNCTIONS:
-    - save_table_corners(): Stores the corners of the detected table for later use.
-    - save_ids(): Stores the IDs of the detected balls for later use.
+    - save_table_corners(): Stores the corners of the detected table for later use. They are refreshed when a detection frame (first, last, rest state, --redetect-every) finds that the camera moved: the frames in between keep the old corners. The pockets of the tracker follow every new calibration.
+    - save_ids(): Stores the IDs of the detected balls for later use. With track classification the IDs come from the track classifier, started on the detected balls.
+
+    NOTES:
+    - `draw_frame` and `project` only read the given `renderState` and only touch the projecter (and their own stage histogram, per thread), so they can run on another thread while the analysis methods already work on the next frame.
+    - detect_table, detect_balls, initializeTrackers, updateTrackers, draw_frame and project are timed with `TIME_STAGE` (see `stageTimer.h`).
 */
 
 #ifndef FRAMEHANDLER_INCLUDED
@@ -31,38 +47,88 @@
 #include <iostream>
 
 #include "table.h"
+#include "tableCalibration.h"
 #include "ballDetection.h"
 #include "trajectoryTracking.h"
 #include "trajectoryProjection.h"
+#include "processingOptions.h"
+#include "shotSegmenter.h"
+#include "frameContext.h"
+#include "trackClassifier.h"
+#include "ballAssignment.h"
+#include "stageTimer.h"
+
+#include <memory>
+
+struct renderState{
+
+    std::vector<cv::Point> hull;                    //table borders of the last detection
+    std::vector<cv::Point2f> corners;               //table corners of the last detection
+    cv::Mat homography;                             //frame -> minimap of the current calibration
+    std::vector<cv::Point2f> centers;
+    std::vector<std::vector<cv::Point2f>> trajectory_tails;    //per ball: last point already sent + points added since
+    std::vector<int> ids;
+
+};
 
 class frameHandler{
 
 private:
 
+    frameContext context;
     tableDetector table;
+    tableCalibration calibration;
     ballDetector detector;
     trajectoryTracker tracker;
     trajectoryProjecter projecter;
+    shotSegmenter shots;
+    int shots_table_id;                 //calibration the table mask of `shots` comes from
+    trackClassifier classes;
+    bool track_classes;                 //classes from the evidence of the tracks instead of the last detection
+    long long resyncs;                  //resyncs with a new detection
+    long long restarted;                //trackers restarted by the resyncs
 
     std::vector<cv::Point2f> table_corners;
     std::vector<int> starting_ids;
+    std::vector<size_t> sent_points;    //trajectory points already handed to a renderState
+
+    double tracker_scale;               //scale of the tracker input (1 = whole frame, full resolution)
+    cv::Rect tracker_crop;              //region of the frame the tracker input comes from
+    int tracker_table_id;               //calibration tracker_crop comes from
+    std::shared_ptr<stageProfiler> timings;     //shared: the profiler is not copyable, the handler is
+
+    std::vector<int> center_ids() const;
+    cv::Mat tracker_input(const cv::Mat& frame);
 
 public:
 
+    static constexpr double RESYNC_DRIFT = 0.25;  //of the detected box side, periodic resyncs
+    static const int TRACKER_MARGIN = 32;           //around the table in the tracker input, full resolution px
+
     cv::Mat bbox_data;
     cv::Mat classification_res;
 
-    explicit frameHandler();
+    explicit frameHandler(const processingOptions& options);
 
-    void detect_table(const cv::Mat& frame);
+    void begin_frame(const cv::Mat& frame);
+    void detect_table();
     void save_table_corners();
-    void detect_balls(const cv::Mat& frame);
-    void detect_balls_final(const cv::Mat& frame);
+    void detect_balls();
     void initializeTrackers(const cv::Mat& frame);
     void save_ids();
+    bool detect_rest(const cv::Mat& frame, int frame_index);
+    void resync_trackers(const cv::Mat& frame, bool restart_all);
+    const shotSegmenter& finish_shots(int last_frame);
     void updateTrackers(const cv::Mat& frame);
-    cv::Mat project(const cv::Mat& frame);
-    cv::Mat draw_frame(const cv::Mat& frame);
+    void reserve_history(int frames);
+    stageProfiler* stage_profiler() const;
+    void skip_frames(int frames);
+    double max_displacement() const;
+    bool save_trajectories(const std::string& path) const;
+    void print_tracker_stats() const;
+    void save_state(renderState& state);
+    void draw_frame(const cv::Mat& frame, cv::Mat& w_borders_on, const renderState& state);
+    cv::Mat project(const cv::Mat& frame, const renderState& state);
 
 };
 
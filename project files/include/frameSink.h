@@ -0,0 +1,49 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: frameSink.h
+    DESCRIPTION: Defines the optional sinks that can be attached to `videoHandler` to observe the processed frames.
+
+    CLASSES:
+    - class frameSink: Abstract interface receiving every processed frame and the intermediate results of the detection frames.
+    - class previewSink: Interactive preview that shows the frames through HighGUI windows.
+
+    METHODS:
+    - void show_frame(...): Receives the final frame (borders + minimap) that is written to the output video.
+    - void show_midstep(...): Receives the bounding boxes and the segmentation mask of a frame where detection ran. `wait` is true for the first and last frame.
+
+    NOTES:
+    - `videoHandler` runs headless when no sink is attached: in that case no HighGUI function is ever called, so it can run on machines without a display.
+*/
+
+#ifndef FRAMESINK_INCLUDED
+#define FRAMESINK_INCLUDED
+
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+#include <iostream>
+
+class frameSink{
+
+public:
+
+    virtual ~frameSink() {}
+
+    virtual void show_frame(const cv::Mat& ret_frame) = 0;
+    virtual void show_midstep(const cv::Mat& bb_frame, const cv::Mat& mask, bool wait) = 0;
+
+};
+
+class previewSink : public frameSink{
+
+public:
+
+    explicit previewSink();
+
+    void show_frame(const cv::Mat& ret_frame) override;
+    void show_midstep(const cv::Mat& bb_frame, const cv::Mat& mask, bool wait) override;
+
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: processingOptions.h
+    DESCRIPTION: Collects the options that control how a video is processed. Filled in by `main` from the command line and passed down to `videoHandler`.
+
+    STRUCTS:
+    - struct processingOptions: Execution options of a single clip.
+
+    FIELDS:
+    - MIDSTEP_flag: Runs the detection on every frame and shows the intermediate results (if a sink is attached).
+    - pipelined: Runs decode, analysis, render and encode as concurrent stages connected by bounded queues. The output is identical to the sequential run.
+    - shot_events: Splits the clip into shots from the motion over the table. When the balls come to rest after a shot the balls are detected and classified again and the trackers re-synchronized on the detections. The shot timeline is printed and saved next to the output video.
+    - queue_capacity: Capacity of every queue between two pipeline stages.
+    - fused_table: Segments the table with the fused single-pass path instead of the default one.
+    - table_pyramid_levels: Pyramid levels of the coarse-to-fine table detection (0 = detection at full resolution). With N levels the table is found on a frame downscaled by 2^N, then only its borders are refined at full resolution.
+    - quad_corners: Finds the table corners by fitting a quadrilateral on the hull instead of intersecting Hough lines. Always gives 4 corners.
+    - distance_circles: Finds the ball candidates with the distance transform detector instead of HoughCircles.
+    - detection_threads: Threads running the ball detection on overlapping tiles of the table (0 = machine size, 1 = serial on the whole table).
+    - incremental_detection: Detects the balls again only where the table changed since the last detection, keeping the balls that did not move.
+    - redetect_interval: Detects the balls every K frames and matches the detections with the trackers (optimal assignment): the trackers that drifted are restarted on the detected boxes, the others keep running (0 = only first frame, last frame and rest states).
+    - frame_stride: Analyzes one frame every N (1 = every frame). The frames in between are only grabbed, not retrieved: the trajectories are interpolated over them and the output video repeats the last analyzed frame. The first and the last frame are always analyzed.
+    - stride_displacement: Move of a ball between two analyzed frames, in px, above which the stride is halved (down to 1). It doubles again, up to `frame_stride`, when every ball moves less than half of it.
+    - track_classification: Keeps a stable class for every tracked ball, voted by all the detections matched with it, instead of taking the class of the last detection.
+    - tracker_backend: Backend of the ball trackers (CSRT, KCF, MOSSE or the purpose-built ball tracker).
+    - motion_threshold: Mean absolute gray difference over the patch of a ball below which the ball is considered still and its tracker update is skipped (0 = always update).
+    - tracker_scale: Scale of the frames given to the trackers (1 = whole frame at full resolution). Below 1 the trackers get the bounding box of the table downscaled by this factor; their boxes are brought back to full resolution before the trajectories and the minimap.
+    - tracker_threads: Threads used to initialize and update the ball trackers of a clip (0 = machine size, 1 = serial).
+    - timings_json: Saves the latency percentiles of every stage next to the output video, as JSON. They are printed anyway in verbose mode (unless the timers are compiled out).
+    - verbose: Prints the progress and the results of the clip. Turned off by the batch runner, which prints one table for all the clips.
+*/
+
+#ifndef PROCESSINGOPTIONS_INCLUDED
+#define PROCESSINGOPTIONS_INCLUDED
+
+#include "ballTracker.h"
+
+struct processingOptions{
+
+    bool MIDSTEP_flag = false;
+    bool shot_events = false;
+    bool pipelined = false;
+    int queue_capacity = 4;
+    bool fused_table = false;
+    int table_pyramid_levels = 0;
+    bool quad_corners = false;
+    bool distance_circles = false;
+    int detection_threads = 1;
+    bool incremental_detection = false;
+    int redetect_interval = 0;
+    int frame_stride = 1;
+    double stride_displacement = 12.0;
+    bool track_classification = false;
+    trackerBackend tracker_backend = TRACKER_CSRT;
+    double motion_threshold = 3.0;
+    double tracker_scale = 1.0;
+    int tracker_threads = 0;
+    bool timings_json = false;
+    bool verbose = true;
+
+};
+
+#endif
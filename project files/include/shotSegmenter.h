@@ -0,0 +1,85 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: shotSegmenter.h
+    DESCRIPTION: Defines the shotSegmenter class, which splits a clip into shots from the motion over the table.
+
+    CLASSES:
+    - enum shotEvent: Event produced by a frame (none, shot started, balls at rest again).
+    - struct shotRecord: A shot of the timeline (first and last frame of the motion, peak motion energy).
+    - class shotSegmenter: Motion energy over the table and rest/motion state machine.
+
+    MAIN FUNCTIONS:
+    - shotSegmenter(): Constructor to initialize the shotSegmenter object with the default thresholds.
+    - void set_table(...): Sets the table mask the motion is measured on. Called again when the table changes.
+    - shotEvent update(...): Measures the motion energy of the frame against the previous one and advances the state machine.
+    - void finish(...): Closes the shot still in progress at the end of the clip.
+    - void print_timeline(): Prints the shots found so far.
+    - bool save_timeline(...): Writes the shots found so far to a text file.
+
+    NOTES:
+    - The motion energy is the number of pixels of the table (on a frame downscaled to `WIDTH` columns) whose gray level changed more than `pixel_threshold` since the previous frame.
+    - A shot starts when the energy goes above `start_threshold` and ends after `rest_frames` consecutive frames below `rest_threshold`: the gap between the two thresholds avoids flickering between the states.
+    - The player is outside of the table mask most of the time, so a rest state is declared only when the balls stopped moving.
+*/
+
+#ifndef SHOTSEGMENTER_INCLUDED
+#define SHOTSEGMENTER_INCLUDED
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum shotEvent{
+    SHOT_NONE,
+    SHOT_START,
+    SHOT_END
+};
+
+struct shotRecord{
+
+    int start_frame;
+    int end_frame;          //first frame of the rest state
+    int peak_energy;
+
+};
+
+class shotSegmenter{
+
+private:
+
+    cv::Rect table_rect;        //bounding box of the table in the frame
+    double scale;               //downscaled size / frame size
+    cv::Mat table_mask;         //downscaled mask of the table
+    cv::Mat small_bgr, previous, current, diff;
+
+    bool moving;
+    int quiet_frames;
+    int start_frame;
+    int peak_energy;
+
+public:
+
+    static const int WIDTH = 256;
+
+    int pixel_threshold;        //gray levels
+    int start_threshold;        //changed pixels
+    int rest_threshold;
+    int rest_frames;
+
+    int energy;                 //motion energy of the last frame
+    std::vector<shotRecord> shots;
+
+    explicit shotSegmenter();
+
+    void set_table(const cv::Mat& seg_mask);
+    shotEvent update(const cv::Mat& frame, int frame_index);
+    void finish(int last_frame);
+    void print_timeline() const;
+    bool save_timeline(const std::string& path) const;
+
+};
+
+#endif
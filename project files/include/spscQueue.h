@@ -0,0 +1,101 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: spscQueue.h
+    DESCRIPTION: Bounded lock-free single-producer/single-consumer queue used to connect the stages of the video pipeline.
+
+    CLASSES:
+    - class spscQueue<T>: Ring buffer with atomic head/tail indexes. Exactly one thread may push and exactly one thread may pop.
+
+    METHODS:
+    - bool try_push(...) / bool try_pop(...): Non blocking operations, return false if the queue is full/empty.
+    - void push(...) / void pop(...): Spin (yielding the thread) until the operation succeeds.
+    - void print_stats(...): Prints how full the queue got and how many times each side had to wait.
+
+    NOTES:
+    - Occupancy statistics are sampled by the producer at every push, the wait counters by the side that waited. They must be read only after both threads have been joined.
+    - A queue that is often full (many producer waits) means the consumer stage is the bottleneck, a queue that is often empty means the producer is.
+*/
+
+#ifndef SPSCQUEUE_INCLUDED
+#define SPSCQUEUE_INCLUDED
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+
+template <typename T>
+class spscQueue{
+
+private:
+
+    std::vector<T> buffer;          //one slot is always left empty to tell full from empty
+    std::atomic<size_t> head;       //next slot to pop, written by the consumer
+    std::atomic<size_t> tail;       //next slot to push, written by the producer
+
+    //stats
+    size_t max_size;
+    size_t sum_size;
+    size_t pushes;
+    size_t producer_waits;
+    size_t consumer_waits;
+
+public:
+
+    explicit spscQueue(size_t capacity) : buffer(capacity + 1), head(0), tail(0),
+        max_size(0), sum_size(0), pushes(0), producer_waits(0), consumer_waits(0) {}
+
+    size_t capacity() const { return buffer.size() - 1; }
+
+    bool try_push(const T& value){
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) % buffer.size();
+        size_t h = head.load(std::memory_order_acquire);
+        if (next == h)
+            return false;   //full
+
+        buffer[t] = value;
+        tail.store(next, std::memory_order_release);
+
+        size_t size = (next + buffer.size() - h) % buffer.size();
+        max_size = std::max(max_size, size);
+        sum_size += size;
+        pushes++;
+        return true;
+    }
+
+    bool try_pop(T& value){
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;   //empty
+
+        value = buffer[h];
+        head.store((h + 1) % buffer.size(), std::memory_order_release);
+        return true;
+    }
+
+    void push(const T& value){
+        while (!try_push(value)){
+            producer_waits++;
+            std::this_thread::yield();
+        }
+    }
+
+    void pop(T& value){
+        while (!try_pop(value)){
+            consumer_waits++;
+            std::this_thread::yield();
+        }
+    }
+
+    void print_stats(const std::string& name) const {
+        double avg_size = pushes > 0 ? static_cast<double>(sum_size) / pushes : 0.0;
+        std::cout << name << ": capacity " << capacity() << " | max " << max_size << " | avg " << avg_size
+                  << " | producer waits " << producer_waits << " | consumer waits " << consumer_waits << std::endl;
+    }
+
+};
+
+#endif
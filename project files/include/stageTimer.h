@@ -0,0 +1,128 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: stageTimer.h
+    DESCRIPTION: Low-overhead latency instrumentation of the processing stages: scoped timers feeding per-thread histograms, with a percentile report at the end of a run.
+
+    STRUCTS:
+    - enum timedStage: The instrumented stages.
+    - struct stageHistogram: Log-linear histograms of the durations of every stage, written by a single thread.
+    - struct stageSummary: Count, mean and percentiles of one stage, in ms.
+
+    CLASSES:
+    - class stageProfiler: Owns the histograms of the threads that recorded a duration and merges them for the report.
+    - class scopedStageTimer: Measures its own lifetime and records it for the given stage.
+
+    METHODS:
+    - void record(...): Adds a duration (ns) to the histogram of the calling thread.
+    - stageSummary summary(...): Merges the histograms of all the threads for one stage.
+    - void print_report(): Prints p50/p90/p99/max of every stage that recorded something.
+    - bool save_json(...): Writes the same report to a JSON file.
+    - const char* stage_name(...): Name of a stage, as printed and written.
+
+    NOTES:
+    - Each thread writes only its own histogram, without locks or atomics. A thread takes the registry lock only the first time it records for a profiler, then it finds its histogram through a thread-local cache. The histograms are read after the stages stopped (e.g. after the pipeline threads joined).
+    - A histogram has 8 linear buckets per power of two of nanoseconds: the percentiles are within 1/16 of their value (middle of the bucket), the max is exact.
+    - The timers are placed with `TIME_STAGE(profiler, stage)`, which expands to nothing unless `STAGE_TIMERS` is defined (CMake option `STAGE_TIMERS`, on by default). When compiled out the report says so.
+*/
+
+#ifndef STAGETIMER_INCLUDED
+#define STAGETIMER_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum timedStage{
+    STAGE_DECODE,
+    STAGE_GRAB,
+    STAGE_DETECT_TABLE,
+    STAGE_DETECT_BALLS,
+    STAGE_INIT_TRACKERS,
+    STAGE_UPDATE_TRACKERS,
+    STAGE_DRAW_FRAME,
+    STAGE_PROJECT,
+    STAGE_ENCODE,
+    STAGE_COUNT
+};
+
+struct stageHistogram{
+
+    static const int SUB_BUCKETS = 8;               //linear buckets per power of two
+    static const int BUCKETS = 64 * SUB_BUCKETS;
+
+    uint64_t counts[STAGE_COUNT][BUCKETS];
+    uint64_t samples[STAGE_COUNT];
+    uint64_t total_ns[STAGE_COUNT];
+    uint64_t max_ns[STAGE_COUNT];
+
+};
+
+struct stageSummary{
+
+    long long count;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+
+};
+
+class stageProfiler{
+
+private:
+
+    int id;                                                 //unique, key of the thread-local cache
+    std::mutex registry_mutex;                              //taken once per thread
+    std::vector<std::unique_ptr<stageHistogram>> histograms;
+    std::vector<std::thread::id> owners;                    //thread of every histogram
+
+    stageHistogram& local();
+
+public:
+
+    explicit stageProfiler();
+
+    void record(timedStage stage, int64_t ns);
+    stageSummary summary(timedStage stage) const;
+    void print_report() const;
+    bool save_json(const std::string& path) const;
+
+};
+
+const char* stage_name(timedStage stage);
+
+class scopedStageTimer{
+
+private:
+
+    stageProfiler* profiler;
+    timedStage stage;
+    std::chrono::steady_clock::time_point start;
+
+public:
+
+    scopedStageTimer(stageProfiler* profiler, timedStage stage) : profiler(profiler), stage(stage), start(std::chrono::steady_clock::now()) {}
+
+    ~scopedStageTimer(){
+        if (this->profiler != nullptr)
+            this->profiler->record(this->stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start).count());
+    }
+
+};
+
+#define STAGE_TIMER_CONCAT_INNER(a, b) a##b
+#define STAGE_TIMER_CONCAT(a, b) STAGE_TIMER_CONCAT_INNER(a, b)
+
+#ifdef STAGE_TIMERS
+  #define TIME_STAGE(profiler, stage) scopedStageTimer STAGE_TIMER_CONCAT(stage_timer_, __LINE__)(profiler, stage)
+#else
+  #define TIME_STAGE(profiler, stage) ((void)0)
+#endif
+
+#endif
@@ -8,19 +8,29 @@
 
     METHODS:
     - tableDetector::tableDetector(): Default constructor for initializing the `tableDetector` object.
-    - cv::Scalar get_dominant_color(): Calculates the dominant color in the image by analyzing the hue channel in HSV color space. The dominant color is returned with mid-range saturation and brightness.
+    - cv::Scalar get_dominant_color(...): Calculates the dominant color in the image by analyzing the hue channel in HSV color space. The dominant color is returned with mid-range saturation and brightness.
     - cv::Mat treshold_mask(...): Creates a binary mask of the image where the pixels fall within the specified color range. Applies Gaussian blur to smooth the image before thresholding.
     - cv::Mat find_largest_comp(...): Identifies the largest connected component in the binary mask. Performs morphological closing to remove small holes and noise.
     - std::vector<cv::Point> find_contour(...): Finds the contour of the largest connected component. Uses `findContours` to extract the contour points.
     - std::vector<cv::Point> get_hull(...): Computes the convex hull of the contour.
-    - void find_table(...): Main method for detecting the table. It calculates the dominant color, thresholds the image, finds the largest component, determines the table color, detects contours, computes the convex hull, and finds table corners.
-    - cv::Mat draw_borders(...): Draws the detected table borders and corners on the image for visualization.
+    - void find_table(...): Main method for detecting the table, on the frame of the given context (the HSV conversion is shared through it).
+    - void segment_default(...): Default segmentation path: dominant color, blurred thresholding, largest component and its mean color.
+    - void finish_table(...): Contour, segmentation mask and hull of the table from the mask of the largest component (shared by both paths).
+    - void segment_fused(...): Fused segmentation path: hue histogram on a subsampled grid, hue-range mask in a single pass over the HSV image, largest component mask and its mean color in a single pass over the labels. Used by `find_table` when `fused` is set.
+    - cv::Mat draw_borders(...): Draws the detected table borders and corners on the image for visualization. A static overload draws given borders and corners into a reusable output image.
     - cv::Point2f get_intersection_point(...): Computes the intersection point of two lines defined by their endpoints. Handles cases where lines are parallel.
-    - std::vector<cv::Point2f> tableDetector::find_corners(): Detects and returns corners of the table by finding intersections of detected lines. 
+    - std::vector<cv::Point2f> tableDetector::find_corners(...): Detects and returns corners of the table by finding intersections of detected lines. The pixel parameters are multiplied by the given scale, so it can also run on a downscaled frame.
+    - void find_table_pyramid(...): Pyramid mode of `find_table`: segmentation and corners on the frame downscaled by 2^`pyramid_levels`, then the boundary is refined at full resolution in the tiles it crosses and the corners by line fits on the full resolution contour.
+    - void refine_mask(...): Upscales the coarse mask and thresholds again at full resolution only the tiles along its boundary.
+    - std::vector<cv::Point2f> refine_corners(...): Fits a line on the full resolution contour points near each side of the coarse quadrilateral and intersects consecutive sides.
+    - std::vector<cv::Point2f> find_quad_corners(): Corners from the hull geometry alone: quadrilateral approximation of the hull (smallest enclosing rectangle if none), then a line fit on the contour points along each side. Used instead of `find_corners` when `quad_corners` is set.
 
     NOTES:
     - The color thresholding is manually tuned for the table's expected color in the HSV color space.
     - The `find_corners` method uses the Hough Line Transform to detect lines and their intersections, which are then used to identify table corners.
+    - `find_quad_corners` always returns 4 corners sorted clockwise and does not touch the image: its cost depends only on the number of contour points. The Hough path can return any number of corners.
+    - In pyramid mode only the tiles along the boundary of the table are converted and thresholded at full resolution, and the Hough transform of `find_corners` runs on the small frame: the cost depends little on the input resolution.
+    - The fused path skips the Gaussian blur of the HSV image (the closing removes the isolated pixels it would have smoothed) and reads one pixel every `SAMPLE_STEP` in both directions for the histogram. Its mask matches the one of the default path up to a few pixels along the borders (see the table benchmark in `benchmark.h`).
 */
 
 #ifndef TABLE_INCLUDE
@@ -31,20 +41,36 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 
+#include "frameContext.h"
+
 class tableDetector{
 
   private:
 
       cv::Mat origin_frame;
       cv::Mat table_roi;
+      cv::Mat blurred_hsv;
+      cv::Mat labels, stats, centroids;
+
+      cv::Mat small_frame;                //pyramid mode buffers
+      frameContext small_context;
+      cv::Mat tile_hsv, tile_thresh, tile_allowed;
 
-      cv::Scalar get_dominant_color();
-      cv::Mat treshold_mask(const cv::Scalar& color);
+      void segment_default(frameContext& context, cv::Mat& mask);
+      void segment_fused(frameContext& context, cv::Mat& mask);
+      void finish_table(const cv::Mat& mask);
+      void find_table_pyramid(frameContext& context);
+      void refine_mask(const cv::Mat& frame, const cv::Mat& small_mask, int factor, cv::Mat& mask);
+      std::vector<cv::Point2f> refine_corners(const std::vector<cv::Point2f>& coarse, const cv::Mat& mask, int factor);
+
+      cv::Scalar get_dominant_color(frameContext& context);
+      cv::Mat treshold_mask(frameContext& context, const cv::Scalar& color);
       cv::Mat find_largest_comp(const cv::Mat& mask);
       std::vector<cv::Point> find_contour(const cv::Mat& mask);
       std::vector<cv::Point> get_hull(const std::vector<cv::Point>&);
 
-      std::vector<cv::Point2f> find_corners();
+      std::vector<cv::Point2f> find_corners(double scale = 1.0);
+      std::vector<cv::Point2f> find_quad_corners();
       cv::Point2f get_intersection_point(const cv::Vec4i& line1, const cv::Vec4i& line2);
 
   public:
@@ -57,9 +83,16 @@ class tableDetector{
       float hue_color;
       cv::Scalar bgr_color;
 
+      static const int SAMPLE_STEP = 4;   //histogram grid of the fused path
+      bool fused;                         //use the fused segmentation path
+      int pyramid_levels;                 //0 = full resolution, N = coarse detection at 1/2^N
+      static const int REFINE_BLOCK = 8;  //side of the refinement tiles, in coarse pixels
+      bool quad_corners;                  //corners from the hull geometry instead of the Hough lines
+
       explicit tableDetector();
-      void find_table(const cv::Mat& img);
+      void find_table(frameContext& context);
       cv::Mat draw_borders(const cv::Mat& img);
+      static void draw_borders(const cv::Mat& img, cv::Mat& edited, const std::vector<cv::Point>& hull, const std::vector<cv::Point2f>& corners);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: tableCalibration.h
+    DESCRIPTION: Definition of the tableCalibration class, which caches the table geometry while the camera does not move.
+
+    CLASS: tableCalibration
+
+    METHODS:
+    - tableCalibration::tableCalibration(): Default constructor, the calibration starts invalid.
+    - void calibrate(...): Stores the result of a `tableDetector` run (mask, borders, corners), computes the homography towards the minimap and the table orientation, and takes the current frame as reference view.
+    - bool camera_moved(...): Cheap check of the camera motion against the reference view, using phase correlation on a small grayscale version of the frame.
+
+    FUNCTIONS:
+    - cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points): Computes the centroid of a given set of points.
+    - std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners): Sorts corners in clockwise order based on their angle from the centroid.
+
+    NOTES:
+    - The table has to be detected again only when `camera_moved` returns true: for a fixed camera the segmentation, the corners and the homography are computed once.
+    - `id` changes at every calibration, so the consumers of the homography can tell when it has been replaced.
+    - A new homography matrix is allocated at every calibration, so copies of the old one handed to other threads stay valid.
+*/
+
+#ifndef TABLECALIBRATION_INCLUDED
+#define TABLECALIBRATION_INCLUDED
+
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+#include <iostream>
+
+#include "table.h"
+
+cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points);
+std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners);
+
+class tableCalibration{
+
+  private:
+
+      // Motion check parameters
+      int reference_width;          //width of the downscaled frames
+      double max_shift;             //max camera shift (full-res px) still considered fixed
+      double min_response;          //min phase correlation peak still considered the same view
+
+      cv::Mat reference;            //downscaled grayscale reference view (CV_32F)
+      cv::Mat window;               //Hanning window of the phase correlation
+      cv::Mat small_bgr, small_gray, small_float;
+      double scale;                 //reference size / frame size
+
+      void make_reference(const cv::Mat& frame, cv::Mat& out);
+
+  public:
+
+      bool valid;
+      int id;
+
+      cv::Mat seg_mask;
+      std::vector<cv::Point> contour;
+      std::vector<cv::Point> hull;
+      std::vector<cv::Point2f> corners;
+
+      cv::Mat homography;           //frame -> minimap
+      bool isVertical;
+
+      explicit tableCalibration();
+      void calibrate(const cv::Mat& frame, const tableDetector& table, const std::vector<cv::Point2f>& dstCorners);
+      bool camera_moved(const cv::Mat& frame);
+};
+
+#endif
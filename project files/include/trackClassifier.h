@@ -0,0 +1,71 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: trackClassifier.h
+    DESCRIPTION: Defines the trackClassifier class, which gives each tracked ball a stable class from the evidence of all its detections.
+
+    CLASSES:
+    - struct classEvidence: Evidence collected for a single track (votes per class, summed pattern statistics, current class).
+    - class trackClassifier: Class evidence of every track and stable labels.
+
+    MAIN FUNCTIONS:
+    - trackClassifier(): Constructor to initialize the trackClassifier object with the default thresholds.
+    - void reset(...): Starts over with the given number of tracks, without evidence.
+    - void observe(...): Adds the pattern of a detection matched with a track (its per-frame class is a vote) and updates the class of the track.
+    - bool confident(...): True when the track has enough observations and a clear majority: its detections do not need to be analyzed again.
+    - int label(...): Class of a track (0 if never observed).
+    - std::vector<int> labels(): Classes of all the tracks, indexed as the trackers.
+    - BallPattern mean_pattern(...): Mean white and black percentages of a track, with its class.
+    - void print_stats(): Prints how many observations were used and how many were skipped for confident tracks.
+
+    NOTES:
+    - The class of a track changes only when another class gets strictly more votes, so a single wrong detection never flips it.
+    - Classes follow `ballDetector::classifyBalls`: 1 white, 2 black, 3 solid, 4 striped.
+*/
+
+#ifndef TRACKCLASSIFIER_INCLUDED
+#define TRACKCLASSIFIER_INCLUDED
+
+#include <iostream>
+#include <vector>
+
+#include "ballDetection.h"
+
+struct classEvidence{
+
+    int votes[5];           //per class (index = class id, 0 unused)
+    int observations;
+    double white_sum;       //sum of the white percentages of the observations
+    double black_sum;
+    int label;              //current class (0 = none yet)
+
+};
+
+class trackClassifier{
+
+private:
+
+    std::vector<classEvidence> tracks;
+
+public:
+
+    int min_observations;       //before a track can be confident
+    double min_confidence;      //share of the votes of the current class
+
+    long long observed;         //observations used, since the start
+    long long skipped;          //detections of confident tracks, not analyzed
+
+    explicit trackClassifier();
+
+    void reset(size_t num_tracks);
+    void observe(size_t track, const BallPattern& pattern);
+    bool confident(size_t track) const;
+    int label(size_t track) const;
+    std::vector<int> labels() const;
+    BallPattern mean_pattern(size_t track) const;
+    size_t size() const;
+    void print_stats() const;
+
+};
+
+#endif
@@ -8,13 +8,16 @@
     - class trajectoryProjecter: Class for projecting the balls' trajectory onto a bird eye view minimap.
 
     FUNCTIONS:
-    - cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points): Computes the centroid of a given set of points.
-    - std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners): Sorts corners in clockwise order based on their angle from the centroid.
     - trajectoryProjecter::trajectoryProjecter(): Constructor for the trajectoryProjecter class.
-    - void trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectories, const std::vector<int>& id_balls, const std::vector<cv::Point2f>& corners): Projects ball positions and trajectories onto a table minimap and displays the result.
+    - void trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const std::vector<int>& id_balls, const cv::Mat& perspectiveMatrix): Projects ball positions and trajectories onto a table minimap and displays the result. `trajectoryTails` holds for every ball the last point already drawn followed by the new ones.
+    - std::vector<cv::Point2f> trajectoryProjecter::minimapCorners(): Returns the table corners on the minimap, the destination of the homography computed by `tableCalibration`.
+    - bool trajectoryProjecter::loadBackground(): Loads, resizes and converts the table minimap image. Called once.
+    - void trajectoryProjecter::drawNewSegments(...): Projects and draws on the trajectory layer the segments of the trajectory tails.
 
     NOTES:
     - The table minimap image should be placed in the "../res/" directory.
+    - The trajectories are accumulated on a persistent layer, so the cost per frame does not grow with the length of the clip. The output is the same as redrawing every trajectory from its first point.
+    - When the camera moves the old segments stay on the layer: they were projected with the homography of the view they were tracked in.
     - The function `projectBalls` overlays the table minimap image onto the bottom-left corner of the input frame.
     - Balls and their trajectories are drawn on the minimap image with colors assigned based on their IDs.
 */
@@ -23,6 +26,7 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <map>
 
 #ifndef trajectoryProjection_INCLUDED
   #define trajectoryProjection_INCLUDED
@@ -31,12 +35,25 @@ class trajectoryProjecter{
 
   private: 
 
-    std::vector<cv::Point2f> balls_centers;
+    // Define the size for the table image on the frame
+    static const int MINIMAP_WIDTH = 300;
+    static const int MINIMAP_HEIGHT = 150;
+    cv::Size tableImageSize;
+
+    std::map<int, cv::Scalar> colorMap;
+
+    cv::Mat background;                             //resized minimap, loaded once
+    cv::Mat trajectoryLayer;                        //background + every segment drawn so far
+    std::vector<cv::Point2f> birdEyePoints;
+
+    bool loadBackground();
+    void drawNewSegments(const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const cv::Mat& perspectiveMatrix);
 
   public:
 
     explicit trajectoryProjecter();
-    cv::Mat projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& centers, const std::vector<std::vector<cv::Point2f>>& trajectories, const std::vector<int>& id_balls, std::vector<cv::Point2f>& corners);
+    cv::Mat projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& centers, const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const std::vector<int>& id_balls, const cv::Mat& perspectiveMatrix);
+    static std::vector<cv::Point2f> minimapCorners();
 
 };
 
@@ -2,26 +2,112 @@
     AUTHOR: Girardello Sofia 
     DATE: 2024-07-21
     FILE: trajectoryTracking.h
-    DESCRIPTION: Defines the trajectory tracking class using OpenCV trackers.
+    DESCRIPTION: Defines the trajectory tracking class using one ballTracker per ball.
 
     CLASSES:
+    - struct ballHistory: Trajectory of a single ball stored as structure of arrays (positions and frame indexes).
+    - struct trajectoryView: Read-only view on the history of a ball, no copy involved.
+    - struct gatingStats: Balls updated by their tracker and balls skipped because they did not move, in the last frame and in total.
+    - enum trackState: Lifecycle of a ball (active, lost, pocketed, retired).
+    - struct trackCounts: Number of balls in every state.
     - class trajectoryTracker: Class for tracking the trajectories of multiple objects.
 
     MAIN FUNCTIONS:
     - trajectoryTracker(): Constructor to initialize the trajectoryTracker object.
     - void initializeTrackers(...): Initializes trackers for the given bounding boxes.
     - void updateTrackers(...): Updates the trackers with the current frame and stores the centers and trajectories.
+    - void resyncTrackers(...): Restarts the trackers that got a new box (e.g. from a new detection), keeping their history.
+    - void skipFrames(...): Advances the frame counter over frames that are not analyzed (temporal stride). Their positions are interpolated at the next update.
+    - double max_displacement(): Largest move of a ball between the last two analyzed frames, in px.
+    - void set_input_transform(...): Sets where the frames given to the trackers come from (offset of the region in the full frame, scale factor). Boxes in, boxes and points out are always in full frame coordinates.
+    - cv::Rect last_bbox(...): Box of the i-th ball at its last successful update.
+    - void reserve_history(...): Reserves the history of every ball for the given number of frames.
+    - void set_backend(...): Selects the backend of the trackers created from now on (default CSRT).
+    - void set_thread_budget(...): Sets how many threads initialize and update the trackers (0 = machine size, 1 = serial).
+    - void set_motion_threshold(...): Sets the motion gating threshold (0 = always update).
+    - const gatingStats& gating_stats(): Counters of the motion gating.
+    - void set_pockets(...): Places the six pockets from the four table corners (corners plus the middle of the long sides).
+    - trackState state(...): Lifecycle state of the i-th ball.
+    - trackCounts track_counts(): Number of balls in every state.
+    - bool reacquire(...): Bounded local search of a lost ball around its last box, by template matching of its last appearance.
+    - bool nearPocket(...): True if the given point is within `pocket_radius` of a pocket.
+    - cv::Rect toInput(...) / toFrame(...): Box from full frame to input coordinates and back.
+    - size_t num_trajectories(): Number of tracked balls.
+    - trajectoryView trajectory(...): View on the history of the i-th ball (i = tracker index).
+
+    NOTES:
+    - The views point into the storage of the tracker: they are valid until the next call to `updateTrackers`.
+    - With the history reserved for the whole clip, `updateTrackers` does not allocate and its cost does not depend on the frames already seen.
+    - The trackers are independent, so they are initialized and updated in parallel. Every tracker writes only its own slot and the results are collected in tracker order, so the output does not depend on the number of threads.
+    - Lifecycle: a tracker that fails becomes lost, or pocketed if its last position is near a pocket. A lost ball is searched every frame in a window around its last box that grows with the frames since the loss, up to `MAX_SEARCH_MARGIN`; when found its tracker restarts there, after `MAX_LOST_FRAMES` it is retired. Pocketed and retired balls are not updated any more and a new detection (`resyncTrackers`) can bring a ball back to active. The changes of state are printed only when `verbose` is set (the batch runner turns it off); the final counts are in `track_counts`.
+    - `centers` holds the balls found in the last frame only: `center_tracks` gives the tracker index of each of them, so the per-tracker data (e.g. the classes) can be aligned with it.
+    - Reduced input: the trackers can work on a downscaled crop of the frame (see `set_input_transform`). The boxes kept inside (`last_bboxes`, patches, search windows) are in input coordinates, so the search margins are scaled with the input. The boxes are brought back to full frame coordinates before they reach the trajectories, the centers and `last_bbox`. When the region changes (new table calibration) the boxes are moved to the new input and the active trackers restarted there on the next update.
+    - Temporal stride: when frames were skipped since the last update, the positions of every ball tracked on both sides of the gap are filled in at constant velocity between the two tracked positions and flagged as interpolated, so the history keeps one point per frame. Balls lost before the gap are not filled.
+    - Motion gating: before updating a tracker, the gray patch under its last box is compared with the same patch at its last real update. If the mean absolute difference is below the threshold the ball did not move: the last position is reused and the tracker update is skipped. Comparing with the last real update (not the previous frame) keeps slow balls from drifting under the threshold frame after frame.
 */
 
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <functional>
+#include <memory>
 
+#include "workerPool.h"
+#include "ballTracker.h"
 
 #ifndef TRAJECTORYTRACKING_INCLUDED
   #define TRAJECTORYTRACKING_INCLUDED
 
+  struct ballHistory{
+
+    std::vector<cv::Point2f> points;
+    std::vector<int> frames;
+    std::vector<unsigned char> interpolated;    //1 = frame skipped by the temporal stride, position interpolated
+
+  };
+
+  struct trajectoryView{
+
+    const cv::Point2f* points;
+    const int* frames;
+    const unsigned char* interpolated;
+    size_t length;
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const cv::Point2f& operator[](size_t i) const { return points[i]; }
+    const cv::Point2f& back() const { return points[length - 1]; }
+    const cv::Point2f* begin() const { return points; }
+    const cv::Point2f* end() const { return points + length; }
+
+  };
+
+  struct gatingStats{
+
+    int updated;            //last frame
+    int skipped;
+    long long tot_updated;  //since the first frame
+    long long tot_skipped;
+
+  };
+
+  enum trackState{
+    TRACK_ACTIVE,
+    TRACK_LOST,
+    TRACK_POCKETED,
+    TRACK_RETIRED
+  };
+
+  struct trackCounts{
+
+    int active;
+    int lost;
+    int pocketed;
+    int retired;
+
+  };
+
   class trajectoryTracker{
 
     /*
@@ -30,18 +116,74 @@
 
     private: 
 
-    std::vector<std::vector<cv::Point2f>> ballTrajectories;
-    std::vector<cv::Ptr<cv::Tracker>> trackers;
+    std::vector<ballHistory> ballTrajectories;
+    std::vector<cv::Ptr<ballTracker>> trackers;
+    trackerBackend backend;
+    size_t reserved_frames;
+    int frame_index;
+    int last_update_frame;                  //frame of the last call to updateTrackers
+    double max_step;                        //largest move of a ball in the last update, px
+
+    std::shared_ptr<workerPool> pool;       //nullptr = serial
+    std::vector<unsigned char> update_ok;   //per-tracker results of the last update
+    std::vector<cv::Rect> update_bboxes;
+
+    double motion_threshold;                    //mean abs gray difference, 0 = gating off
+    std::vector<cv::Rect> last_bboxes;          //box of the last real update
+    std::vector<cv::Mat> reference_patches;     //gray patch under last_bboxes at the last real update
+    std::vector<cv::Mat> current_patches;       //buffers of the check, reused between frames
+    std::vector<unsigned char> update_skipped;
+    gatingStats stats;
+
+    std::vector<trackState> states;             //lifecycle of every ball
+    std::vector<trackState> previous_states;    //before the last update, to report the changes
+    std::vector<int> lost_frames;               //frames since the loss, lost balls only
+    std::vector<cv::Point2f> pockets;
+    std::vector<cv::Mat> search_windows;        //buffers of the re-acquisition, per tracker
+    std::vector<cv::Mat> search_responses;
+
+    cv::Point2f input_offset;                   //region of the full frame given to the trackers
+    double input_scale;                         //and its scale factor
+    std::vector<unsigned char> restart_pending; //per tracker, after a change of the input region
+
+    void forEachTracker(int count, const std::function<void(int)>& body);
+    bool ballMoved(const cv::Mat& frame, size_t i);
+    bool reacquire(const cv::Mat& frame, size_t i);
+    bool nearPocket(const cv::Rect& bbox) const;
+    cv::Rect toInput(const cv::Rect& bbox) const;
+    cv::Rect toFrame(const cv::Rect& bbox) const;
     
     public:
 
+    static const int SEARCH_MARGIN = 8;         //re-acquisition window around the last box, full resolution px (grows by this every frame)
+    static const int MAX_SEARCH_MARGIN = 48;
+    static const int MAX_LOST_FRAMES = 30;      //then the ball is retired
+    static constexpr double REACQUIRE_SCORE = 0.6;  //min normalized correlation of a re-acquisition
+
     std::vector<cv::Point2f> centers;
-    std::vector<std::vector<cv::Point2f>> trajectories;
+    std::vector<size_t> center_tracks;          //tracker index of every center
+    double pocket_radius;
+    bool verbose;                               //prints the changes of state of the balls
 
     explicit trajectoryTracker();
 
     void initializeTrackers(const cv::Mat& frame, const std::vector<cv::Rect>& centers);
     void updateTrackers(const cv::Mat& frame);
+    void resyncTrackers(const cv::Mat& frame, const std::vector<cv::Rect>& bboxes);
+    void skipFrames(int frames);
+    double max_displacement() const;
+    void set_input_transform(const cv::Point2f& offset, double scale);
+    cv::Rect last_bbox(size_t i) const;
+    void reserve_history(size_t frames);
+    void set_backend(trackerBackend backend);
+    void set_thread_budget(int threads);
+    void set_motion_threshold(double threshold);
+    const gatingStats& gating_stats() const;
+    void set_pockets(const std::vector<cv::Point2f>& table_corners);
+    trackState state(size_t i) const;
+    trackCounts track_counts() const;
+    size_t num_trajectories() const;
+    trajectoryView trajectory(size_t i) const;
 
 
   };
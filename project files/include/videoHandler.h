@@ -10,7 +10,12 @@
     - videoHandler(const std::string& folder_name): Constructor that initializes the `videoHandler` object by setting up paths and loading necessary files based on the provided folder name.
     - void load_files(): Loads segmentation mask and bounding box data for the first and last frames. Handles errors if files cannot be loaded.
     - cv::Mat load_txt_data(...): Reads bounding box data from a text file and stores it in a `cv::Mat` matrix.
-    - void process_video(...): Processes the video file frame by frame. Calls `frameHandler` to perform table and ball detection. Displays intermediate results based on the `MIDSTEP_flag` and writes processed frames to an output video file.
+    - void attach_sink(...): Attaches an optional sink (e.g. the interactive preview) that receives the processed frames. Without a sink the video is processed headless.
+    - void process_video(...): Processes the video file frame by frame. Calls `frameHandler` to perform table and ball detection. Forwards intermediate results to the attached sink based on the `MIDSTEP_flag`, writes processed frames to an output video file and reports wall time and fps.
+    - int run_sequential(...): Runs decode, analysis, render and encode one after the other on the calling thread. With a temporal stride the frames between two analyzed ones are only grabbed, and the last output frame is written again for each of them.
+    - int run_pipelined(...): Runs decode, analysis and render on their own threads and encodes on the calling thread. Stages are connected by bounded lock-free queues of recycled frame buffers.
+    - void analyze_frame(...) / render_frame(...) / collect_frame(...): The three steps shared by both runs, so that the pipelined output is identical to the sequential one.
+    - void finish_run(...): Reports of the analysis at the end of both runs (tracker statistics, shot timeline, stage latencies) and saves the trajectories.
     - cv::Mat displayMask(...): Converts and displays segmentation masks using a predefined color map for different classes.
     - cv::Mat plot_bb(...): Draws bounding boxes on the source image using colors based on class labels.
 
@@ -19,8 +24,13 @@
 
     IMPORTANT:
     - Ensure the paths and file names used in `load_files` match the actual dataset structure.
-    - The output video and metrics are saved to the `../build/output` directory. Ensure this directory is writable.
+    - The output video and metrics are saved to the `../build/output` directory. Ensure this directory is writable. With `shot_events` the shot timeline is saved there too, as `<folder_name>_shots.txt`. The trajectories are always saved, as `<folder_name>_trajectories.txt`. With `timings_json` the stage latencies are saved as `<folder_name>_timings.json`.
     - The `MIDSTEP_flag` allows toggling between visualizing all frames or just the first and last frames for debugging purposes.
+    - With `redetect_interval` = K the balls are also detected every K frames and the drifted trackers are restarted on the detections, which bounds the drift of a tracker to K frames.
+    - With `frame_stride` > 1 the video always runs sequentially: the next analyzed frame depends on the motion measured on the current one.
+    - `videoHandler` holds no static or shared state: several instances can process different clips at the same time in one process (see `batchRunner`).
+    - Decode (grab for the frames skipped by the stride) and encode are timed with `TIME_STAGE` in both runs, next to the stages of `frameHandler`.
+    - The pipelined run keeps the frame order and produces the same output video as the sequential one. Queue statistics are printed at the end to spot the bottleneck stage.
 */
 
 #ifndef VIDEOHANDLER_INCLUDED
@@ -35,11 +45,32 @@
 #include <opencv2/core/utils/filesystem.hpp>
 #include <filesystem>
 
+#include "frameSink.h"
+#include "frameHandler.h"
+#include "processingOptions.h"
+#include "spscQueue.h"
+
+// Buffers of a frame travelling through the stages of the video pipeline
+struct framePacket{
+
+    int index;                      //1-based frame number
+    cv::Mat frame;                  //decoded frame
+    cv::Mat w_borders_on;           //frame with table borders
+    cv::Mat ret_frame;              //final frame (borders + minimap)
+    bool detected;                  //detection ran on this frame
+    int skipped;                    //frames skipped by the temporal stride right before this one
+    cv::Mat bbox_data;
+    cv::Mat classification_res;
+    renderState state;
+
+};
+
 class videoHandler{
 
 private:
 
     std::string folder_name;
+    frameSink* sink;            //optional, nullptr = headless
 
     //seg-masks
     cv::Mat ffirst_mask;        //groundtruth
@@ -56,13 +87,25 @@ private:
     void load_files();
     cv::Mat load_txt_data(const std::string& path);
 
+    int run_sequential(cv::VideoCapture& capture, cv::VideoWriter& writer, int tot_frames, const processingOptions& options);
+    int run_pipelined(cv::VideoCapture& capture, cv::VideoWriter& writer, int tot_frames, const processingOptions& options);
+    void analyze_frame(frameHandler& frame_handler, framePacket& packet, int tot_frames, const processingOptions& options);
+    void render_frame(frameHandler& frame_handler, framePacket& packet);
+    void collect_frame(frameHandler& frame_handler, cv::VideoWriter& writer, framePacket& packet, int tot_frames);
+    void finish_run(frameHandler& frame_handler, int tot_frames, const processingOptions& options);
+
 public:
 
     bool errors;
+    int frames_processed;
+    double elapsed_s;
+    double mAP;
+    double mIoU;
 
     explicit videoHandler(const std::string& folder_name);
-    
-    void process_video(int MIDSTEP_flag);
+
+    void attach_sink(frameSink* sink);
+    void process_video(const processingOptions& options);
     cv::Mat plot_bb(const cv::Mat& src, const cv::Mat& bb);
     cv::Mat displayMask(const cv::Mat& mask);
 
@@ -0,0 +1,63 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: workerPool.h
+    DESCRIPTION: Definition of a small pool of persistent worker threads used to run independent jobs in parallel.
+
+    CLASSES:
+    - class workerPool: Fixed set of threads that execute the iterations of a parallel loop.
+
+    METHODS:
+    - workerPool(int num_threads): Starts the workers. With 0 the pool is sized to the machine (hardware threads).
+    - int size() const: Number of threads taking part in a loop, calling thread included.
+    - void parallel_for(...): Runs body(0..count-1) on the pool and returns when every iteration is done. Iterations are handed out one at a time, so faster threads take more of them.
+
+    NOTES:
+    - The calling thread works as well, so a pool of size 1 starts no thread at all and runs the loop inline.
+    - Each iteration must write only its own results (e.g. slot i of a vector) to keep the outcome independent of the scheduling.
+    - parallel_for must not be called concurrently on the same pool.
+*/
+
+#ifndef WORKERPOOL_INCLUDED
+#define WORKERPOOL_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class workerPool{
+
+private:
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+
+    const std::function<void(int)>* body;   //current loop, valid while a loop runs
+    int count;
+    std::atomic<int> next;                  //next iteration to hand out
+    int generation;                         //incremented at every new loop
+    int busy;                               //workers still inside the current loop
+    bool stopping;
+
+    void worker_loop();
+    void run_iterations();
+
+public:
+
+    explicit workerPool(int num_threads = 0);
+    ~workerPool();
+
+    workerPool(const workerPool&) = delete;
+    workerPool& operator=(const workerPool&) = delete;
+
+    int size() const;
+    void parallel_for(int count, const std::function<void(int)>& body);
+
+};
+
+#endif
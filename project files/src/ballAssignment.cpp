@@ -0,0 +1,234 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: ballAssignment.cpp
+    DESCRIPTION: Implements the optimal assignment between tracked balls and detected balls, with a spatial grid to find the candidate pairs.
+
+    CLASSES:
+    - class spatialGrid: Uniform grid of points, to find the points near a position without comparing with all of them.
+
+    FUNCTIONS:
+    - std::vector<int> hungarian(...): Minimum cost assignment of the rows of a cost matrix to its columns (rows <= columns).
+    - std::vector<assignmentPair> assignDetections(...): Matches tracks and detections minimizing the total distance, among the pairs closer than the gate of the detection.
+    - std::vector<assignmentPair> assignDetections(..., excluded): Same assignment, leaving out the excluded tracks (e.g. pocketed balls). The result refers to the indices of all the tracks.
+*/
+
+#include "ballAssignment.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+spatialGrid::spatialGrid(const std::vector<cv::Point2f>& points, double cell_size){
+    this->points = points;
+    this->cell = std::max(1.0, cell_size);
+    this->cols = 0;
+    this->rows = 0;
+    if (points.empty())
+        return;
+
+    // Bounds of the points
+    cv::Point2f low = points[0], high = points[0];
+    for (const cv::Point2f& p : points) {
+        low.x = std::min(low.x, p.x);
+        low.y = std::min(low.y, p.y);
+        high.x = std::max(high.x, p.x);
+        high.y = std::max(high.y, p.y);
+    }
+    this->origin = low;
+
+    // Far apart points (e.g. a track lost out of the view) enlarge the cells, not their number
+    double extent = std::max(high.x - low.x, high.y - low.y);
+    this->cell = std::max(this->cell, extent / MAX_SIDE);
+    this->cols = static_cast<int>((high.x - low.x) / this->cell) + 1;
+    this->rows = static_cast<int>((high.y - low.y) / this->cell) + 1;
+    this->cells.assign(static_cast<size_t>(this->cols) * this->rows, std::vector<size_t>());
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        int cx = static_cast<int>((points[i].x - low.x) / this->cell);
+        int cy = static_cast<int>((points[i].y - low.y) / this->cell);
+        this->cells[static_cast<size_t>(cy) * this->cols + cx].push_back(i);
+    }
+}
+
+void spatialGrid::query(const cv::Point2f& position, double radius, std::vector<size_t>& found) const{
+    found.clear();
+    if (this->cells.empty())
+        return;
+
+    // Cells touched by the square around the position
+    int x0 = std::max(0, static_cast<int>(std::floor((position.x - radius - this->origin.x) / this->cell)));
+    int y0 = std::max(0, static_cast<int>(std::floor((position.y - radius - this->origin.y) / this->cell)));
+    int x1 = std::min(this->cols - 1, static_cast<int>(std::floor((position.x + radius - this->origin.x) / this->cell)));
+    int y1 = std::min(this->rows - 1, static_cast<int>(std::floor((position.y + radius - this->origin.y) / this->cell)));
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (size_t i : this->cells[static_cast<size_t>(cy) * this->cols + cx]) {
+                if (cv::norm(this->points[i] - position) < radius)
+                    found.push_back(i);
+            }
+        }
+    }
+    std::sort(found.begin(), found.end());
+}
+
+
+// Hungarian algorithm (potentials, O(n^2 m)). Returns for every row the column assigned to it.
+static std::vector<int> hungarian(const std::vector<std::vector<double>>& cost){
+    int n = static_cast<int>(cost.size());
+    int m = static_cast<int>(cost[0].size());
+    const double inf = std::numeric_limits<double>::max();
+
+    std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0);
+    std::vector<int> p(m + 1, 0), way(m + 1, 0);
+    for (int i = 1; i <= n; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        std::vector<double> minv(m + 1, inf);
+        std::vector<char> used(m + 1, false);
+        do {
+            used[j0] = true;
+            int i0 = p[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= m; ++j) {
+                if (used[j])
+                    continue;
+                double cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    std::vector<int> assigned(n, -1);
+    for (int j = 1; j <= m; ++j) {
+        if (p[j] != 0)
+            assigned[p[j] - 1] = j - 1;
+    }
+    return assigned;
+}
+
+
+static size_t findRoot(std::vector<size_t>& parent, size_t i){
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+
+std::vector<assignmentPair> assignDetections(const std::vector<cv::Point2f>& tracks, const std::vector<cv::Point2f>& detections, const std::vector<double>& gates){
+
+    std::vector<assignmentPair> result;
+    if (tracks.empty() || detections.empty())
+        return result;
+
+    // Candidate pairs within the gate of the detection, through a grid of the tracks
+    double max_gate = 0.0;
+    for (double gate : gates)
+        max_gate = std::max(max_gate, gate);
+    spatialGrid grid(tracks, max_gate);
+
+    std::vector<assignmentPair> candidates;
+    std::vector<size_t> near;
+    for (size_t j = 0; j < detections.size(); ++j) {
+        grid.query(detections[j], gates[j], near);
+        for (size_t i : near)
+            candidates.push_back({i, j, cv::norm(tracks[i] - detections[j])});
+    }
+    if (candidates.empty())
+        return result;
+
+    // Groups of tracks and detections linked by a candidate pair (tracks first, then detections)
+    size_t num_tracks = tracks.size();
+    std::vector<size_t> parent(num_tracks + detections.size());
+    for (size_t k = 0; k < parent.size(); ++k)
+        parent[k] = k;
+    for (const assignmentPair& c : candidates)
+        parent[findRoot(parent, c.track)] = findRoot(parent, num_tracks + c.detection);
+
+    std::vector<std::vector<size_t>> group_tracks(parent.size()), group_detections(parent.size());
+    for (const assignmentPair& c : candidates) {
+        size_t root = findRoot(parent, c.track);
+        if (std::find(group_tracks[root].begin(), group_tracks[root].end(), c.track) == group_tracks[root].end())
+            group_tracks[root].push_back(c.track);
+        if (std::find(group_detections[root].begin(), group_detections[root].end(), c.detection) == group_detections[root].end())
+            group_detections[root].push_back(c.detection);
+    }
+
+    // Optimal assignment inside every group
+    const double gated_out = 1e9;
+    for (size_t root = 0; root < parent.size(); ++root) {
+        std::vector<size_t>& rows_ids = group_tracks[root];
+        std::vector<size_t>& cols_ids = group_detections[root];
+        if (rows_ids.empty())
+            continue;
+        std::sort(rows_ids.begin(), rows_ids.end());
+        std::sort(cols_ids.begin(), cols_ids.end());
+
+        // The algorithm needs rows <= columns: transpose if there are more tracks than detections
+        bool transposed = rows_ids.size() > cols_ids.size();
+        const std::vector<size_t>& r_ids = transposed ? cols_ids : rows_ids;
+        const std::vector<size_t>& c_ids = transposed ? rows_ids : cols_ids;
+        std::vector<std::vector<double>> cost(r_ids.size(), std::vector<double>(c_ids.size(), gated_out));
+        for (const assignmentPair& c : candidates) {
+            if (findRoot(parent, c.track) != root)
+                continue;
+            size_t r = std::lower_bound(r_ids.begin(), r_ids.end(), transposed ? c.detection : c.track) - r_ids.begin();
+            size_t k = std::lower_bound(c_ids.begin(), c_ids.end(), transposed ? c.track : c.detection) - c_ids.begin();
+            cost[r][k] = c.distance;
+        }
+
+        std::vector<int> assigned = hungarian(cost);
+        for (size_t r = 0; r < assigned.size(); ++r) {
+            if (assigned[r] < 0 || cost[r][assigned[r]] >= gated_out)
+                continue;
+            size_t track = transposed ? c_ids[assigned[r]] : r_ids[r];
+            size_t detection = transposed ? r_ids[r] : c_ids[assigned[r]];
+            result.push_back({track, detection, cost[r][assigned[r]]});
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const assignmentPair& a, const assignmentPair& b) { return a.track < b.track; });
+    return result;
+}
+
+std::vector<assignmentPair> assignDetections(const std::vector<cv::Point2f>& tracks, const std::vector<cv::Point2f>& detections, const std::vector<double>& gates, const std::vector<bool>& excluded){
+
+    // Assignment among the remaining tracks, then back to the indices of all the tracks
+    std::vector<cv::Point2f> kept;
+    std::vector<size_t> kept_ids;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        if (i < excluded.size() && excluded[i])
+            continue;
+        kept.push_back(tracks[i]);
+        kept_ids.push_back(i);
+    }
+
+    std::vector<assignmentPair> result = assignDetections(kept, detections, gates);
+    for (assignmentPair& pair : result)
+        pair.track = kept_ids[pair.track];
+    return result;
+}
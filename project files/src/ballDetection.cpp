@@ -9,16 +9,27 @@
 
     MAIN FUNCTIONS:
     - ballDetector(): Constructor to initialize the ballDetector object.
-    - void detectBalls(...): Handles the detection and calls the other functions.
-    - void applyColourDetection(...): Performs detection using Hough Transform on colour masks.
-    - void selectBalls(...): Select just the acceptable balls using colour thresholding masks.
-    - BallPattern analyzeBallPattern(...): Analyzes the ball pattern based on its appearance.
+    - void detectBalls(...): Handles the detection and calls the other functions. The frame and its Lab/gray conversions come from the frame context.
+    - bool cropTable(...): Crop of the table with its margin, outside mask and gray crop of the frame. False on invalid inputs.
+    - void convertTable(...): Masked BGR (`table_roi`) and Lab (`table_lab`) crops of the frame.
+    - void applyColourDetection(...): Performs detection using Hough Transform (or the distance transform detector, if `distance_circles` is set) on colour masks, starting from the Lab image of the table.
+    - void set_thread_budget(...): Sets how many threads run the detection (1 = serial on the whole table, otherwise tiled).
+    - bool detectBallsIncremental(...): Incremental mode of `detectBalls`: keeps the balls of the last detection whose box did not change and searches again only the changed regions of the table. Returns false when too much of the table changed.
+    - void finishDetection(...): Common end of both modes: back to frame coordinates, classification, metric matrices and state for the next incremental detection.
+    - void findCircles(...): Circle search on a colour mask with the selected detector (HoughCircles or distance transform).
+    - void set_known_balls(...): Sets the balls whose class is already known (e.g. confident tracks): a candidate on one of them takes its pattern instead of being analyzed again. Empty vectors turn it off.
+    - void print_stats(): Prints how many detections were full or incremental and the share of the table searched (incremental mode only).
+    - void tiledColourDetection(...): Tiled mode of `applyColourDetection`: thresholding and circle search on overlapping tiles of the table in parallel, then merge of the circles.
+    - void findCirclesDistance(...): Ball-specific circle detector: distance transform of the pixels that are not cloth, local maxima with a value in the radius range, check of the cloth around each maximum and suppression of the maxima closer than `min_circle_distance`.
+    - void selectBalls(...): Select just the acceptable balls using colour thresholding masks. The statistics of each candidate are computed on the bounding box of its circle only.
+    - BallPattern analyzeBallPattern(...): Analyzes the ball pattern based on its appearance, on the grayscale patch of the ball.
     - void classifyBalls(...): Classifies each ball given its colour and pattern analytics.
-    - void detectBallsFinalFrame(...): Detects balls in the final frame and matches with tracker centers.
     - void saveInfo(...): Stores important information about each single selected ball.
 
     ADDITIONAL FUNCTIONS: 
-    - enhanceContrast(...): Enhances the contrast of the input image using CLAHE (Contrast Limited Adaptive Histogram Equalization) in the LAB color space. Improves the visibility of features in the image.
+    - enhanceContrast(...): Enhances the contrast of the input image, given in the LAB color space, using CLAHE (Contrast Limited Adaptive Histogram Equalization). Improves the visibility of features in the image. The CLAHE object is owned by the detector and reused.
+    - averageHue(...): Average hue of the given area (the cloth in the middle of the table).
+    - hueThresholding(...): Thresholds the image in HSV around the given hue. The hue is taken once per full detection and reused by the tiles and by the incremental regions.
     - detectedBallsData(...): Constructs a matrix with information about detected balls, including their bounding boxes and IDs.
     - createLabeledImage(...): Creates a labeled image that visualizes detected balls with their corresponding IDs.
 
@@ -31,19 +42,14 @@
 
 //------------ ADDITIONAL FUNCTIONS ------------
 
-cv::Mat enhanceContrast(cv::Mat& frame) {
-
-    // Convert the frame to the LAB color space
-    cv::Mat lab;
-    cv::cvtColor(frame, lab, cv::COLOR_BGR2Lab);
+cv::Mat enhanceContrast(const cv::Mat& lab_frame, const cv::Ptr<cv::CLAHE>& clahe) {
 
     // Split the LAB image into separate channels
+    cv::Mat lab;
     std::vector<cv::Mat> lab_channels(3);
-    cv::split(lab, lab_channels);
+    cv::split(lab_frame, lab_channels);
 
     // Apply CLAHE to the L-channel
-    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE();
-    clahe->setClipLimit(7.0);
     cv::Mat l_channel;
     clahe->apply(lab_channels[0], l_channel);
 
@@ -58,13 +64,9 @@ cv::Mat enhanceContrast(cv::Mat& frame) {
 }
 
 
-cv::Mat averageColourThresholding(const cv::Mat& table_roi, const int areaSize){
+int averageHue(const cv::Mat& table_roi, const cv::Rect& centerRect){
 
-    // Define the area to compute the average
-    int startX = (table_roi.cols - areaSize) / 2;
-    int startY = (table_roi.rows - areaSize) / 2;
-
-    cv::Rect centerRect(startX, startY, areaSize, areaSize);
+    // Area to compute the average
     cv::Mat centerArea = table_roi(centerRect);
 
     // Compute the average BGR color
@@ -76,15 +78,19 @@ cv::Mat averageColourThresholding(const cv::Mat& table_roi, const int areaSize){
     cv::cvtColor(bgrMat, hsvMat, cv::COLOR_BGR2HSV);
     cv::Vec3b hsvColor = hsvMat.at<cv::Vec3b>(0, 0);
 
+    return hsvColor[0];
+
+}
+
+
+void hueThresholding(const cv::Mat& image, int hue, cv::Mat& mask){
+
     // Convert the frame to HSV
     cv::Mat hsv_img;
-    cv::cvtColor(table_roi, hsv_img, cv::COLOR_BGR2HSV);
+    cv::cvtColor(image, hsv_img, cv::COLOR_BGR2HSV);
 
     // Thresholding based on the average center color to isolate balls
-    cv::Mat mask;
-    cv::inRange(hsv_img, cv::Scalar(hsvColor[0] - 7.3, 70, 70), cv::Scalar(hsvColor[0] + 11.9, 255, 255), mask);
-
-    return mask;
+    cv::inRange(hsv_img, cv::Scalar(hue - 7.3, 70, 70), cv::Scalar(hue + 11.9, 255, 255), mask);
 
 }
 
@@ -156,25 +162,110 @@ cv::Mat createLabeledImage(cv::Mat ROI, std::vector<cv::Point2f>& centers, std::
 
 // Constructor 
 ballDetector::ballDetector() {
+    // CLAHE is created once and reused on every frame
+    this->clahe = cv::createCLAHE();
+    this->clahe->setClipLimit(7.0);
+    this->min_circle_distance = 0;
+    this->table_scale = 1.0;
+    this->min_radius = MIN_RADIUS;
+    this->max_radius = MAX_RADIUS;
+    this->distance_circles = false;
+    this->incremental = false;
+    this->has_previous = false;
+    this->cloth_hue = 0;
+    this->stats = detectionStats();
 }
 
 
-void ballDetector::detectBalls(const cv::Mat& currentFrame, const cv::Mat& ROI, const std::vector<cv::Point2f> table_corners) {
+void ballDetector::set_thread_budget(int threads) {
+    // 0 = one thread per hardware thread
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (threads == 1)
+        this->pool.reset();
+    else
+        this->pool = std::make_shared<workerPool>(threads);
+}
+
+
+bool ballDetector::cropTable(frameContext& context, const cv::Mat& ROI) {
+
+    const cv::Mat& currentFrame = context.bgr();
 
     // Input validation
     if (currentFrame.size() != ROI.size() || currentFrame.type() != CV_8UC3 || ROI.type() != CV_8UC1) {
         std::cerr << "Error: Invalid input images!" << std::endl;
+        return false;
+    }
+
+    // Work only on the bounding box of the table: everything outside is masked out anyway.
+    // The margin keeps the circles on the border of the table away from the border of the crop.
+    cv::Rect frameRect(0, 0, currentFrame.cols, currentFrame.rows);
+    cv::Rect tableRect = cv::boundingRect(ROI);
+
+    // Pixel sizes at the scale of this table
+    this->table_scale = tableRect.empty() ? 1.0 : std::max(tableRect.width, tableRect.height) / REFERENCE_TABLE_SIZE;
+    this->min_radius = std::max(1, cvRound(MIN_RADIUS * this->table_scale));
+    this->max_radius = std::max(this->min_radius + 1, cvRound(MAX_RADIUS * this->table_scale));
+    int margin = std::max(CROP_MARGIN, this->max_radius + 1);
+
+    this->crop = cv::Rect(tableRect.x - margin, tableRect.y - margin, tableRect.width + 2*margin, tableRect.height + 2*margin) & frameRect;
+    if (tableRect.empty())
+        this->crop = frameRect;
+    this->frame_size = currentFrame.size();
+    this->min_circle_distance = currentFrame.rows / 24;
+
+    // Gray of the masked crop, from the conversions of the frame shared through the context.
+    // Outside of the table it is set to the value of black pixels (gray 0), as if converted from table_roi.
+    cv::compare(ROI(this->crop), 0, this->outside_mask, cv::CMP_EQ);
+    context.gray(this->crop).copyTo(this->gray_roi);
+    this->gray_roi.setTo(cv::Scalar(0), this->outside_mask);
+
+    return true;
+}
+
+
+void ballDetector::convertTable(frameContext& context, const cv::Mat& ROI) {
+
+    const cv::Mat& currentFrame = context.bgr();
+
+    this->table_roi.create(this->crop.size(), currentFrame.type());
+    this->table_roi.setTo(cv::Scalar::all(0));
+    currentFrame(this->crop).copyTo(this->table_roi, ROI(this->crop)); // Mask the current frame with ROI
+
+    // Lab of the masked crop, from the context as well (0,128,128 outside of the table)
+    context.lab(this->crop).copyTo(this->table_lab);
+    this->table_lab.setTo(cv::Scalar(0, 128, 128), this->outside_mask);
+}
+
+
+void ballDetector::detectBalls(frameContext& context, const cv::Mat& ROI, const std::vector<cv::Point2f> table_corners) {
+
+    cv::Rect previous_crop = this->crop;
+    if (!cropTable(context, ROI))
+        return;
+
+    std::vector<cv::Point2f> crop_corners;
+    for (const cv::Point2f& corner : table_corners)
+        crop_corners.push_back(corner - cv::Point2f(this->crop.tl()));
+
+    // Incremental mode: only where the table changed since the last detection (same table only)
+    std::vector<BallPattern> ballPatterns;
+    if (this->incremental && this->has_previous && this->crop == previous_crop &&
+        detectBallsIncremental(context.bgr(), ROI, crop_corners, ballPatterns)) {
+        finishDetection(ROI, ballPatterns);
+        this->stats.incremental++;
         return;
     }
 
-    currentFrame.copyTo(this->table_roi, ROI); // Mask the current frame with ROI
+    convertTable(context, ROI);
 
     // Define the needed variables
-    cv::Mat colour_mask;
     std::vector<cv::Vec3f> circles;
 
     // Apply a colour thresholding and Hough Transform using the dedicated function
-    applyColourDetection(this->table_roi, colour_mask, circles);        
+    applyColourDetection(this->table_lab, this->colour_mask, circles);        
 
     // Clear previous centers and trajectories
     this->centers.clear();
@@ -183,29 +274,201 @@ void ballDetector::detectBalls(const cv::Mat& currentFrame, const cv::Mat& ROI,
     this->id_balls.clear();
 
     // Recall to the function that filters the balls found by HoughCircles
-    std::vector<BallPattern> ballPatterns;
-    ballPatterns = selectBalls(ROI, colour_mask, circles, table_corners);     // Save the selected balls
+    ballPatterns = selectBalls(ROI(this->crop), this->colour_mask, circles, crop_corners);     // Save the selected balls
+
+    finishDetection(ROI, ballPatterns);
+    this->stats.full++;
+    this->stats.searched_pixels += this->crop.area();
+    this->stats.crop_pixels += this->crop.area();
+
+}
+
+
+void ballDetector::finishDetection(const cv::Mat& ROI, std::vector<BallPattern>& ballPatterns) {
+
+    // Back to frame coordinates
+    cv::Point offset = this->crop.tl();
+    for (size_t i = 0; i < this->centers.size(); ++i) {
+        this->centers[i] += cv::Point2f(offset);
+        this->balls[i] += offset;
+        this->bboxes[i] += offset;
+    }
 
     // Recall to the function that classifies the selected balls
     classifyBalls(ballPatterns);
+    this->patterns = ballPatterns;
 
 
     // Create the matrices that characterize this frame (will be used for metrics purposes)
     this->bbox_data = detectedBallsData(this->bboxes, this->id_balls);
     this->classification_res = createLabeledImage(ROI, this->centers, this->bboxes, this->id_balls);
 
+    // State for the next incremental detection
+    if (this->incremental) {
+        this->gray_roi.copyTo(this->previous_gray);
+        this->previous_patterns = ballPatterns;
+        this->has_previous = true;
+    }
+
+}
+
+
+bool ballDetector::detectBallsIncremental(const cv::Mat& frame, const cv::Mat& ROI, const std::vector<cv::Point2f>& crop_corners, std::vector<BallPattern>& ballPatterns) {
+
+    if (this->previous_gray.size() != this->gray_roi.size() || this->colour_mask.size() != this->gray_roi.size())
+        return false;
+
+    // Pixels of the table that changed since the last detection
+    cv::absdiff(this->gray_roi, this->previous_gray, this->change_mask);
+    cv::threshold(this->change_mask, this->change_mask, CHANGE_THRESHOLD, 255, cv::THRESH_BINARY);
+
+    // Grid of blocks: a block is searched again if enough of its pixels changed
+    cv::Size grid_size((this->crop.width + CHANGE_BLOCK - 1) / CHANGE_BLOCK, (this->crop.height + CHANGE_BLOCK - 1) / CHANGE_BLOCK);
+    this->changed_blocks = cv::Mat::zeros(grid_size, CV_8UC1);
+    cv::Rect cropRect(0, 0, this->crop.width, this->crop.height);
+    for (int by = 0; by < grid_size.height; ++by) {
+        for (int bx = 0; bx < grid_size.width; ++bx) {
+            cv::Rect block = cv::Rect(bx * CHANGE_BLOCK, by * CHANGE_BLOCK, CHANGE_BLOCK, CHANGE_BLOCK) & cropRect;
+            if (cv::countNonZero(this->change_mask(block)) > MIN_CHANGED_PIXELS)
+                this->changed_blocks.at<uchar>(by, bx) = 255;
+        }
+    }
+
+    // Cheap check of the previous balls: a ball is still there if its box did not change.
+    // The box of a ball that moved or vanished is searched again.
+    std::vector<cv::Point> kept_centers;
+    std::vector<int> kept_radii;
+    std::vector<BallPattern> kept_patterns;
+    for (size_t i = 0; i < this->centers.size() && i < this->previous_patterns.size(); ++i) {
+        cv::Point center(cvRound(this->centers[i].x) - this->crop.x, cvRound(this->centers[i].y) - this->crop.y);
+        int radius = this->bboxes[i].width / 2;
+        cv::Rect box = cv::Rect(center.x - radius, center.y - radius, 2*radius + 1, 2*radius + 1) & cropRect;
+        if (box.empty())
+            continue;
+        if (cv::countNonZero(this->change_mask(box)) <= MIN_CHANGED_PIXELS) {
+            kept_centers.push_back(center);
+            kept_radii.push_back(radius);
+            kept_patterns.push_back(this->previous_patterns[i]);
+        } else {
+            cv::Rect blocks(box.x / CHANGE_BLOCK, box.y / CHANGE_BLOCK, (box.br().x - 1) / CHANGE_BLOCK - box.x / CHANGE_BLOCK + 1, (box.br().y - 1) / CHANGE_BLOCK - box.y / CHANGE_BLOCK + 1);
+            this->changed_blocks(blocks).setTo(cv::Scalar(255));
+        }
+    }
+
+    // Changed regions = connected groups of changed blocks
+    int num_regions = cv::connectedComponentsWithStats(this->changed_blocks, this->labels, this->region_stats, this->region_centroids, 8);
+    std::vector<cv::Rect> regions;
+    long long searched = 0;
+    for (int r = 1; r < num_regions; ++r) {
+        cv::Rect region(this->region_stats.at<int>(r, cv::CC_STAT_LEFT) * CHANGE_BLOCK, this->region_stats.at<int>(r, cv::CC_STAT_TOP) * CHANGE_BLOCK,
+                        this->region_stats.at<int>(r, cv::CC_STAT_WIDTH) * CHANGE_BLOCK, this->region_stats.at<int>(r, cv::CC_STAT_HEIGHT) * CHANGE_BLOCK);
+        region &= cropRect;
+        regions.push_back(region);
+        searched += region.area();
+    }
+
+    // Too much motion: the full detection is cheaper
+    if (searched > MAX_CHANGED_FRACTION * cropRect.area())
+        return false;
+
+    // Full search in every changed region, with a band of context around it. The hue of the cloth is the one of the last full detection.
+    std::vector<cv::Vec3f> circles;
+    cv::Mat frame_crop = frame(this->crop);
+    for (const cv::Rect& region : regions) {
+        int overlap = 2*this->max_radius;
+        cv::Rect area = cv::Rect(region.x - overlap, region.y - overlap, region.width + 2*overlap, region.height + 2*overlap) & cropRect;
+        cv::cvtColor(frame_crop(area), this->region_lab, cv::COLOR_BGR2Lab);
+        this->region_lab.setTo(cv::Scalar(0, 128, 128), this->outside_mask(area));
+        cv::Mat edit = enhanceContrast(this->region_lab, this->clahe);
+        hueThresholding(edit, this->cloth_hue, this->region_mask);
+        this->region_mask(region - area.tl()).copyTo(this->colour_mask(region));
+
+        std::vector<cv::Vec3f> found;
+        findCircles(this->region_mask, this->outside_mask(area), found, this->buffers);
+        for (cv::Vec3f& circle : found) {
+            circle[0] += area.x;
+            circle[1] += area.y;
+            if (!region.contains(cv::Point(cvFloor(circle[0]), cvFloor(circle[1]))))
+                continue;
+
+            // A ball that did not move is already known
+            bool known = false;
+            for (const cv::Point& kept : kept_centers) {
+                if (cv::norm(cv::Point2f(circle[0], circle[1]) - cv::Point2f(kept)) < this->min_circle_distance) {
+                    known = true;
+                    break;
+                }
+            }
+            if (!known)
+                circles.push_back(circle);
+        }
+        searched += area.area() - region.area();
+    }
+    this->stats.searched_pixels += searched;
+    this->stats.crop_pixels += cropRect.area();
+
+    // Known balls first, then the selected new ones
+    this->centers.clear();
+    this->balls.clear();
+    this->bboxes.clear();
+    this->id_balls.clear();
+    for (size_t k = 0; k < kept_centers.size(); ++k)
+        saveInfo(kept_centers[k], kept_radii[k]);
+    ballPatterns = kept_patterns;
+
+    std::vector<BallPattern> new_patterns = selectBalls(ROI(this->crop), this->colour_mask, circles, crop_corners);
+    ballPatterns.insert(ballPatterns.end(), new_patterns.begin(), new_patterns.end());
+    return true;
+
+}
+
+
+void ballDetector::set_known_balls(const std::vector<cv::Point2f>& centers, const std::vector<BallPattern>& patterns) {
+    this->known_centers = centers;
+    this->known_patterns = patterns;
 }
 
-void ballDetector::applyColourDetection(cv::Mat& frame, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles) {
+
+void ballDetector::print_stats() const {
+    if (!this->incremental)
+        return;
+    std::cout << "Ball detections: " << this->stats.full << " full, " << this->stats.incremental << " incremental";
+    if (this->stats.crop_pixels > 0)
+        std::cout << ", " << 100.0 * this->stats.searched_pixels / this->stats.crop_pixels << "% of the table searched";
+    std::cout << std::endl;
+}
+
+
+void ballDetector::findCircles(const cv::Mat& mask, const cv::Mat& outside, std::vector<cv::Vec3f>& circles, distanceBuffers& buffers) const {
+    // minDist is based on the rows of the whole frame, not of the crop
+    if (this->distance_circles)
+        findCirclesDistance(mask, outside, circles, buffers);
+    else
+        cv::HoughCircles(mask, circles, cv::HOUGH_GRADIENT, 1.5, this->min_circle_distance, 30, 10.7, this->min_radius, this->max_radius);
+}
+
+void ballDetector::applyColourDetection(const cv::Mat& lab_frame, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles) {
 
     // Enhance contrast
-    cv::Mat edit = enhanceContrast(frame); //NEW
+    cv::Mat edit = enhanceContrast(lab_frame, this->clahe); //NEW
 
     // Define the size of the area around the center to compute the average color
     int areaSize = 50;
 
+    // The area is the center of the whole frame, brought into the crop (or the center of the crop if the frame center is outside of it)
+    cv::Rect centerRect((this->frame_size.width - areaSize) / 2 - this->crop.x, (this->frame_size.height - areaSize) / 2 - this->crop.y, areaSize, areaSize);
+    centerRect &= cv::Rect(0, 0, edit.cols, edit.rows);
+    if (centerRect.width < areaSize || centerRect.height < areaSize)
+        centerRect = cv::Rect((edit.cols - areaSize) / 2, (edit.rows - areaSize) / 2, areaSize, areaSize) & cv::Rect(0, 0, edit.cols, edit.rows);
+
+    if (this->pool) {
+        tiledColourDetection(edit, centerRect, colour_mask, circles);
+        return;
+    }
+
     // Perform colour thresholding to select just the table area (excluded balls)
-    colour_mask = averageColourThresholding(edit, areaSize); //NEW
+    this->cloth_hue = averageHue(edit, centerRect);
+    hueThresholding(edit, this->cloth_hue, colour_mask); //NEW
 
     // Find the balls using Hough Tranform 
     /*
@@ -219,7 +482,7 @@ void ballDetector::applyColourDetection(cv::Mat& frame, cv::Mat& colour_mask, st
         - maxRadius: Maximum circle radius.
     */
     //cv::HoughCircles(colour_mask, circles, cv::HOUGH_GRADIENT, 1.7, colour_mask.rows / 24, 30, 10.7, 5, 15);
-    cv::HoughCircles(colour_mask, circles, cv::HOUGH_GRADIENT, 1.5, colour_mask.rows / 24, 30, 10.7, 5, 15);
+    findCircles(colour_mask, this->outside_mask, circles, this->buffers);
 
     /* --Debug: Draw detected circles on the original table_roi image
     cv::Mat result_hough = table_roi.clone();
@@ -234,11 +497,153 @@ void ballDetector::applyColourDetection(cv::Mat& frame, cv::Mat& colour_mask, st
 
 }
 
+void ballDetector::tiledColourDetection(const cv::Mat& edit, const cv::Rect& centerRect, cv::Mat& colour_mask, std::vector<cv::Vec3f>& circles) {
+
+    // The hue of the cloth is taken once, from the same area as in the serial mode
+    this->cloth_hue = averageHue(edit, centerRect);
+    int hue = this->cloth_hue;
+
+    // Grid of cores covering the crop, each one extended by the overlap on every side
+    std::vector<cv::Rect> cores, tiles;
+    cv::Rect area(0, 0, edit.cols, edit.rows);
+    int overlap = 2*this->max_radius;
+    for (int y = 0; y < edit.rows; y += TILE_SIZE) {
+        for (int x = 0; x < edit.cols; x += TILE_SIZE) {
+            cores.push_back(cv::Rect(x, y, TILE_SIZE, TILE_SIZE) & area);
+            tiles.push_back(cv::Rect(x - overlap, y - overlap, TILE_SIZE + 2*overlap, TILE_SIZE + 2*overlap) & area);
+        }
+    }
+
+    int count = static_cast<int>(tiles.size());
+    colour_mask.create(edit.size(), CV_8UC1);
+    this->tile_circles.resize(count);
+    this->tile_masks.resize(count);
+    this->tile_buffers.resize(count);
+
+    this->pool->parallel_for(count, [&](int t) {
+        const cv::Rect& tile = tiles[t];
+        const cv::Rect& core = cores[t];
+        cv::Mat& tile_mask = this->tile_masks[t];
+        hueThresholding(edit(tile), hue, tile_mask);
+
+        // Every tile writes only its core into the shared mask
+        tile_mask(core - tile.tl()).copyTo(colour_mask(core));
+
+        std::vector<cv::Vec3f> found;
+        findCircles(tile_mask, this->outside_mask(tile), found, this->tile_buffers[t]);
+
+        // A circle belongs to the tile whose core contains its center: the overlap bands are searched twice, kept once
+        this->tile_circles[t].clear();
+        for (cv::Vec3f& circle : found) {
+            circle[0] += tile.x;
+            circle[1] += tile.y;
+            if (core.contains(cv::Point(cvFloor(circle[0]), cvFloor(circle[1]))))
+                this->tile_circles[t].push_back(circle);
+        }
+    });
+
+    // Merge in tile order. Two circles of neighbouring cores can still be closer than the minimum distance: the first one is kept.
+    circles.clear();
+    double min_distance2 = static_cast<double>(this->min_circle_distance) * this->min_circle_distance;
+    for (const std::vector<cv::Vec3f>& found : this->tile_circles) {
+        for (const cv::Vec3f& circle : found) {
+            bool duplicate = false;
+            for (const cv::Vec3f& kept : circles) {
+                double dx = circle[0] - kept[0], dy = circle[1] - kept[1];
+                if (dx*dx + dy*dy < min_distance2) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate)
+                circles.push_back(circle);
+        }
+    }
+}
+
+
+void ballDetector::findCirclesDistance(const cv::Mat& colour_mask, const cv::Mat& outside, std::vector<cv::Vec3f>& circles, distanceBuffers& buffers) const {
+
+    circles.clear();
+
+    // Pixels that are not cloth, inside of the table only (outside of it the holes would join the border of the crop)
+    cv::compare(colour_mask, 0, buffers.holes, cv::CMP_EQ);
+    if (outside.size() == buffers.holes.size())
+        buffers.holes.setTo(cv::Scalar(0), outside);
+
+    // Distance of every hole pixel from the cloth: a ball peaks at its center with its radius
+    cv::distanceTransform(buffers.holes, buffers.distance, cv::DIST_L2, cv::DIST_MASK_5);
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2*this->min_radius + 1, 2*this->min_radius + 1));
+    cv::dilate(buffers.distance, buffers.distance_max, kernel);
+
+    struct peak { float value; int x, y; };
+    std::vector<peak> peaks;
+    for (int y = 0; y < buffers.distance.rows; ++y) {
+        const float* row = buffers.distance.ptr<float>(y);
+        const float* max_row = buffers.distance_max.ptr<float>(y);
+        for (int x = 0; x < buffers.distance.cols; ++x) {
+            if (row[x] >= this->min_radius && row[x] <= this->max_radius + 1 && row[x] == max_row[x])
+                peaks.push_back({row[x], x, y});
+        }
+    }
+
+    // Strongest peaks first, ties in raster order so the result does not depend on the sort
+    std::sort(peaks.begin(), peaks.end(), [](const peak& a, const peak& b) {
+        if (a.value != b.value)
+            return a.value > b.value;
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+
+    double min_distance2 = static_cast<double>(this->min_circle_distance) * this->min_circle_distance;
+    for (const peak& p : peaks) {
+
+        // Same minimum distance between centers as HoughCircles
+        bool too_close = false;
+        for (const cv::Vec3f& circle : circles) {
+            double dx = circle[0] - p.x, dy = circle[1] - p.y;
+            if (dx*dx + dy*dy < min_distance2) {
+                too_close = true;
+                break;
+            }
+        }
+        if (too_close)
+            continue;
+
+        // A ball is surrounded by cloth (at least half of a thin ring around it, the rest being a cushion or another ball).
+        // This rejects the ridges of elongated holes (cues, arms, cushions), whose distance is in the radius range too.
+        float radius = std::min(p.value, static_cast<float>(this->max_radius));
+        float inner = radius + 1.5f, outer = radius + 4.0f;
+        int cloth = 0, ring = 0;
+        int r = static_cast<int>(std::ceil(outer));
+        for (int dy = -r; dy <= r; ++dy) {
+            int y = p.y + dy;
+            if (y < 0 || y >= colour_mask.rows)
+                continue;
+            const uchar* mask_row = colour_mask.ptr<uchar>(y);
+            for (int dx = -r; dx <= r; ++dx) {
+                int x = p.x + dx;
+                float d2 = static_cast<float>(dx*dx + dy*dy);
+                if (x < 0 || x >= colour_mask.cols || d2 <= inner*inner || d2 > outer*outer)
+                    continue;
+                ring++;
+                if (mask_row[x] > 0)
+                    cloth++;
+            }
+        }
+        if (ring == 0 || 2 * cloth < ring)
+            continue;
+
+        circles.push_back(cv::Vec3f(static_cast<float>(p.x), static_cast<float>(p.y), radius));
+    }
+}
+
 std::vector<BallPattern> ballDetector::selectBalls(const cv::Mat& ROI, const cv::Mat& mask, const std::vector<cv::Vec3f>& circles, const std::vector<cv::Point2f> table_corners) {
 
     std::vector<BallPattern> ballPatterns;
 
-    double cornerDistanceThreshold = 60.0; // Min distance from table corner to be considered valid
+    cv::Rect frameRect(0, 0, mask.cols, mask.rows);
+
+    double cornerDistanceThreshold = CORNER_DISTANCE * this->table_scale; // Min distance from table corner to be considered valid
 
     for (size_t i = 0; i < circles.size(); i++) {
 
@@ -261,14 +666,21 @@ std::vector<BallPattern> ballDetector::selectBalls(const cv::Mat& ROI, const cv:
             continue;
         }
 
-        // Create a mask for the detected circle
-        cv::Mat circleMask = cv::Mat::zeros(mask.size(), CV_8UC1);
-        cv::circle(circleMask, center, radius, cv::Scalar(255), -1);
+        // Every statistic is computed on the bounding box of the circle only
+        cv::Rect box = cv::Rect(center.x - radius, center.y - radius, 2*radius + 1, 2*radius + 1) & frameRect;
+        if (box.empty()) {
+            continue;
+        }
+
+        // Create a mask for the detected circle, in box coordinates
+        cv::Mat circleMask = cv::Mat::zeros(box.size(), CV_8UC1);
+        cv::circle(circleMask, center - box.tl(), radius, cv::Scalar(255), -1);
 
         // Check the area inside the circle in both the segmentation mask and the thresholded mask
         cv::Mat segCircle, threshCircle;
-        cv::bitwise_and(ROI, ROI, segCircle, circleMask);
-        cv::bitwise_and(~mask, ~mask, threshCircle, circleMask);
+        cv::bitwise_and(ROI(box), circleMask, segCircle);
+        cv::bitwise_not(mask(box), threshCircle);
+        cv::bitwise_and(threshCircle, circleMask, threshCircle);
         
         // Calculate the area of the white pixels in the segmentation mask and black pixels in the thresholded mask
         double circleArea = cv::countNonZero(circleMask);
@@ -278,8 +690,21 @@ std::vector<BallPattern> ballDetector::selectBalls(const cv::Mat& ROI, const cv:
         // Filter the balls using the colour mask and the ROI analysis
         if (whiteSegArea/circleArea > 0.7 && blackThreshArea/circleArea > 0.6 && blackThreshArea/whiteSegArea > 0.4) { 
 
+            // A ball of known class keeps its pattern, the others are analyzed
+            BallPattern pattern;
+            bool known = false;
+            cv::Point2f frameCenter = centerFloat + cv::Point2f(this->crop.tl());
+            for (size_t k = 0; k < this->known_centers.size(); ++k) {
+                if (cv::norm(frameCenter - this->known_centers[k]) < radius) {
+                    pattern = this->known_patterns[k];
+                    known = true;
+                    break;
+                }
+            }
+
             // Recall to the function that analizes the pattern/colour of the ball
-            BallPattern pattern = analyzeBallPattern(this->table_roi, circleMask);
+            if (!known)
+                pattern = analyzeBallPattern(this->gray_roi(box), circleMask);
             ballPatterns.push_back(pattern);  
 
             // Recall to the function that saves the important info of the current ball
@@ -292,24 +717,19 @@ std::vector<BallPattern> ballDetector::selectBalls(const cv::Mat& ROI, const cv:
 }
 
 
-BallPattern ballDetector::analyzeBallPattern(const cv::Mat& ballROI, const cv::Mat& circleMask) {
-
-    // Desaturate the image by converting into grayscale
-    cv::Mat gray;
-    cv::cvtColor(ballROI, gray, cv::COLOR_BGR2GRAY);
+BallPattern ballDetector::analyzeBallPattern(const cv::Mat& grayBall, const cv::Mat& circleMask) {
 
-    // Select the white areas and the black areas of the image and create two masks
+    // Select the white areas and the black areas of the (already grayscale) patch and create two masks
     cv::Mat binary_white;
-    cv::threshold(gray, binary_white, 190, 255, cv::THRESH_BINARY);
+    cv::threshold(grayBall, binary_white, 190, 255, cv::THRESH_BINARY);
     cv::Mat binary_black;
-    cv::threshold(gray, binary_black, 50, 255, cv::THRESH_BINARY);
-    cv::bitwise_not(binary_black, binary_black);
+    cv::threshold(grayBall, binary_black, 50, 255, cv::THRESH_BINARY_INV);
 
     // Select just the area related to the current studied ball
     cv::Mat maskedBinary_white;
-    binary_white.copyTo(maskedBinary_white, circleMask);
+    cv::bitwise_and(binary_white, circleMask, maskedBinary_white);
     cv::Mat maskedBinary_black;
-    binary_black.copyTo(maskedBinary_black, circleMask);
+    cv::bitwise_and(binary_black, circleMask, maskedBinary_black);
 
     // Analize the percentage of black and white colour in that area
     int whitePixels = cv::countNonZero(maskedBinary_white);
@@ -376,70 +796,6 @@ void ballDetector::classifyBalls(std::vector<BallPattern>& ballPatterns){
 }
 
 
-void ballDetector::detectBallsFinalFrame(const cv::Mat& frame, const cv::Mat& ROI, const std::vector<cv::Point2f>& trackerCenters, const std::vector<int>& trackerIDs, const std::vector<cv::Point2f>& table_corners) {
-
-    // Ensure the size of trackerCenters and trackerIDs are the same
-    assert(trackerCenters.size() == trackerIDs.size());
-
-    // Parameters for circle detection
-    double maxDistance = 20.0; // Max distance to consider a circle as near a tracker
-    int defaultRadius = 10;    // Default radius if no circle is found
-
-    cv::Mat final_table_roi;
-    frame.copyTo(final_table_roi, ROI); // Mask the current frame with ROI
-
-    // Define the needed variables
-    cv::Mat colour_mask;
-    std::vector<cv::Vec3f> circles;
-
-    // Apply a colour thresholding and Hough Transform using the dedicated function
-    applyColourDetection(this->table_roi, colour_mask, circles); 
-
-    // Convert detected circles into DetectedCircle objects
-    struct DetectedCircle {
-        cv::Point2f center;
-        int radius;
-    };
-    std::vector<DetectedCircle> detectedCircles;
-    for (const auto& circle : circles) {
-        DetectedCircle detectedCircle;
-        detectedCircle.center = cv::Point2f(circle[0], circle[1]);
-        detectedCircle.radius = static_cast<int>(circle[2]);
-        detectedCircles.push_back(detectedCircle);
-    }
-    
-    // Iterate over each tracker
-    for (size_t i = 0; i < trackerCenters.size(); ++i) {
-        cv::Point2f trackerCenter = trackerCenters[i];
-        int trackerID = trackerIDs[i];
-
-        bool circleFound = false;
-        cv::Point2f circleCenter = trackerCenter;
-        int circleRadius = defaultRadius;
-
-        // Check if any detected circle is near this tracker
-        for (const auto& detectedCircle : detectedCircles) {
-            if (cv::norm(trackerCenter - detectedCircle.center) < maxDistance) {
-                circleCenter = detectedCircle.center;
-                circleRadius = detectedCircle.radius;
-                circleFound = true;
-                break; // No need to check other circles once a match is found
-            }
-        }
-
-        // Save information
-        saveInfo(circleCenter, circleRadius);
-        this->id_balls.push_back(trackerID);
-
-    }
-
-    // Create the matrices that characterize this frame (will be used for metrics purposes)
-    this->bbox_data = detectedBallsData(this->bboxes, this->id_balls);
-    this->classification_res = createLabeledImage(ROI, this->centers, this->bboxes, this->id_balls);
-
-}
-
-
 void ballDetector::saveInfo(const cv::Point center, const int radius){
 
     // Save the center
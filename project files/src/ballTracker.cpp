@@ -0,0 +1,155 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: ballTracker.cpp
+    DESCRIPTION: Implements the single-ball tracker backends.
+
+    CLASSES:
+    - class opencvBallTracker: Backend wrapping an OpenCV tracker (CSRT, KCF, MOSSE).
+    - class velocityBallTracker: Constant-velocity prediction plus a template search in a small window around the prediction.
+
+    MAIN FUNCTIONS:
+    - cv::Ptr<ballTracker> createBallTracker(...): Creates a tracker of the given backend.
+    - bool parseTrackerBackend(...): Converts a name (csrt, kcf, mosse, ball) to a backend.
+    - std::string trackerBackendName(...): Name of a backend.
+*/
+
+#include "ballTracker.h"
+#include <opencv2/tracking.hpp>
+#include <opencv2/tracking/tracking_legacy.hpp>
+
+bool parseTrackerBackend(const std::string& name, trackerBackend& backend){
+    if (name == "csrt")
+        backend = TRACKER_CSRT;
+    else if (name == "kcf")
+        backend = TRACKER_KCF;
+    else if (name == "mosse")
+        backend = TRACKER_MOSSE;
+    else if (name == "ball")
+        backend = TRACKER_BALL;
+    else
+        return false;
+    return true;
+}
+
+std::string trackerBackendName(trackerBackend backend){
+    switch (backend) {
+        case TRACKER_CSRT: return "csrt";
+        case TRACKER_KCF: return "kcf";
+        case TRACKER_MOSSE: return "mosse";
+        case TRACKER_BALL: return "ball";
+    }
+    return "unknown";
+}
+
+static cv::Ptr<cv::Tracker> createCSRT(){
+
+    // Definition of the parameters defining the trackers
+    cv::TrackerCSRT::Params csrtParams;
+    csrtParams.use_hog = true;               // Use HOG features
+    csrtParams.use_color_names = true;       // Use Color Names features
+    csrtParams.use_gray = true;              // Use Gray features
+    csrtParams.use_rgb = true;               // Use RGB features
+    csrtParams.use_channel_weights = true;   // Use Channel Weights
+    csrtParams.use_segmentation = true;      // Use Segmentation
+    csrtParams.window_function = "hann";     // Window function
+    csrtParams.kaiser_alpha = 4.75;          // Kaiser window parameter
+    csrtParams.cheb_attenuation = 45;        // Chebyshev window parameter
+    csrtParams.template_size = 400;          // Template size
+    csrtParams.gsl_sigma = 2.0;              // Gaussian window parameter
+    csrtParams.hog_orientations = 9;         // HOG orientations
+    csrtParams.num_hog_channels_used = 18;   // Number of HOG channels
+    csrtParams.filter_lr = 0.03;             // Learning rate for the filter
+    csrtParams.weights_lr = 0.03;            // Learning rate for the weights
+    csrtParams.admm_iterations = 7;          // Number of ADMM iterations
+    csrtParams.number_of_scales = 33;        // Number of scales
+    csrtParams.scale_sigma_factor = 0.25;    // Scale sigma factor
+    csrtParams.scale_model_max_area = 512;   // Scale model max area
+    csrtParams.scale_lr = 0.001;             // Scale learning rate
+    csrtParams.scale_step = 1.01;            // Scale step
+    csrtParams.psr_threshold = 0.05;         // PSR threshold
+
+    return cv::TrackerCSRT::create(csrtParams);
+}
+
+cv::Ptr<ballTracker> createBallTracker(trackerBackend backend){
+    switch (backend) {
+        case TRACKER_KCF:
+            return cv::makePtr<opencvBallTracker>(cv::TrackerKCF::create());
+        case TRACKER_MOSSE:
+            // MOSSE is only available through the legacy API
+            return cv::makePtr<opencvBallTracker>(cv::legacy::upgradeTrackingAPI(cv::legacy::TrackerMOSSE::create()));
+        case TRACKER_BALL:
+            return cv::makePtr<velocityBallTracker>();
+        case TRACKER_CSRT:
+        default:
+            return cv::makePtr<opencvBallTracker>(createCSRT());
+    }
+}
+
+
+// ---OpenCV backends----------------------------------------------------------
+
+opencvBallTracker::opencvBallTracker(const cv::Ptr<cv::Tracker>& tracker){
+    this->tracker = tracker;
+}
+
+void opencvBallTracker::init(const cv::Mat& frame, const cv::Rect& bbox){
+    this->tracker->init(frame, bbox);
+}
+
+bool opencvBallTracker::update(const cv::Mat& frame, cv::Rect& bbox){
+    return this->tracker->update(frame, bbox);
+}
+
+
+// ---Ball tracker-------------------------------------------------------------
+
+velocityBallTracker::velocityBallTracker(){
+    this->velocity = cv::Point2f(0, 0);
+}
+
+void velocityBallTracker::init(const cv::Mat& frame, const cv::Rect& bbox){
+    cv::Rect box = bbox & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (frame.channels() == 3)
+        cv::cvtColor(frame(box), this->templ, cv::COLOR_BGR2GRAY);
+    else
+        frame(box).copyTo(this->templ);
+
+    this->position = cv::Point2f(box.x, box.y);
+    this->size = box.size();
+    this->velocity = cv::Point2f(0, 0);
+}
+
+bool velocityBallTracker::update(const cv::Mat& frame, cv::Rect& bbox){
+    if (this->templ.empty())
+        return false;
+
+    // Search only around the predicted position
+    cv::Point2f predicted = this->position + this->velocity;
+    cv::Rect window(cvRound(predicted.x) - SEARCH_MARGIN, cvRound(predicted.y) - SEARCH_MARGIN,
+                    this->size.width + 2*SEARCH_MARGIN, this->size.height + 2*SEARCH_MARGIN);
+    window &= cv::Rect(0, 0, frame.cols, frame.rows);
+    if (window.width < this->templ.cols || window.height < this->templ.rows)
+        return false;
+
+    if (frame.channels() == 3)
+        cv::cvtColor(frame(window), this->gray, cv::COLOR_BGR2GRAY);
+    else
+        frame(window).copyTo(this->gray);
+
+    cv::matchTemplate(this->gray, this->templ, this->response, cv::TM_CCOEFF_NORMED);
+    double max_score;
+    cv::Point max_loc;
+    cv::minMaxLoc(this->response, nullptr, &max_score, nullptr, &max_loc);
+    if (max_score < MIN_SCORE)
+        return false;
+
+    // Constant-velocity model, smoothed to ignore the jitter of the match
+    cv::Point2f found(window.x + max_loc.x, window.y + max_loc.y);
+    this->velocity = VELOCITY_LR * (found - this->position) + (1.0 - VELOCITY_LR) * this->velocity;
+    this->position = found;
+
+    bbox = cv::Rect(cvRound(found.x), cvRound(found.y), this->size.width, this->size.height);
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: batchRunner.cpp
+    DESCRIPTION: Implements the batch processing of all the clips of the dataset on a pool of workers.
+
+    FUNCTIONS:
+    - std::vector<std::string> find_clips(...): Finds every clip folder of the dataset, i.e. every `<name>/<name>.mp4`.
+    - bool run_batch(...): Processes the clips headless on a pool of workers and prints one table with the results of every clip. Returns false if any clip failed.
+    - void print_reports(...): Prints the aggregated table of the results.
+*/
+
+#include "batchRunner.h"
+#include "videoHandler.h"
+#include "workerPool.h"
+
+#include <iomanip>
+
+std::vector<std::string> find_clips(const std::string& dataset_path){
+
+    std::vector<std::string> videos;
+    cv::utils::fs::glob(dataset_path, "*.mp4", videos, true, false);
+
+    // Keep only <name>/<name>.mp4, the layout expected by videoHandler
+    std::vector<std::string> clips;
+    for (const std::string& video : videos) {
+        size_t file_start = video.find_last_of("/\\");
+        if (file_start == std::string::npos || file_start == 0)
+            continue;
+        size_t folder_start = video.find_last_of("/\\", file_start - 1);
+        std::string folder = video.substr(folder_start + 1, file_start - folder_start - 1);
+        std::string file = video.substr(file_start + 1);
+        if (file == folder + ".mp4")
+            clips.push_back(folder);
+    }
+
+    std::sort(clips.begin(), clips.end());
+    return clips;
+}
+
+
+void print_reports(const std::vector<clipReport>& reports, double elapsed_s){
+
+    std::cout << "---BATCH RESULTS-------" << std::endl;
+    std::cout << std::left << std::setw(16) << "clip"
+              << std::right << std::setw(8) << "mAP" << std::setw(8) << "mIoU"
+              << std::setw(8) << "frames" << std::setw(10) << "time[s]" << std::setw(8) << "fps" << std::endl;
+
+    int tot_frames = 0;
+    for (const clipReport& report : reports) {
+        std::cout << std::left << std::setw(16) << report.name << std::right << std::fixed << std::setprecision(3);
+        if (report.errors) {
+            std::cout << std::setw(8) << "-" << std::setw(8) << "-" << std::setw(8) << "-" << std::setw(10) << "-" << std::setw(8) << "-" << "  ERROR" << std::endl;
+            continue;
+        }
+        double fps = report.elapsed_s > 0 ? report.frames / report.elapsed_s : 0.0;
+        std::cout << std::setw(8) << report.mAP << std::setw(8) << report.mIoU << std::setw(8) << report.frames
+                  << std::setprecision(2) << std::setw(10) << report.elapsed_s << std::setprecision(1) << std::setw(8) << fps << std::endl;
+        tot_frames += report.frames;
+    }
+
+    std::cout << std::defaultfloat << std::setprecision(6);
+    std::cout << "Total: " << tot_frames << " frames in " << elapsed_s << " s (" << (elapsed_s > 0 ? tot_frames / elapsed_s : 0.0) << " fps)" << std::endl;
+}
+
+
+bool run_batch(const std::vector<std::string>& clips, const processingOptions& options, int num_workers){
+
+    if (clips.empty()) {
+        std::cerr << "Error: No clip found in the dataset folder." << std::endl;
+        return false;
+    }
+
+    // Output folder created once here, not concurrently by the workers
+    std::string out_folder = "../build/output";
+    if (!cv::utils::fs::exists(out_folder))
+        cv::utils::fs::createDirectories(out_folder);
+
+    if (num_workers <= 0)
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    num_workers = std::min(num_workers, static_cast<int>(clips.size()));
+    std::cout << "Processing " << clips.size() << " clips on " << num_workers << " workers..." << std::endl;
+
+    // Clips run headless and quiet: only the final table is printed
+    processingOptions clip_options = options;
+    clip_options.verbose = false;
+
+    // Share the machine between the clips instead of oversubscribing it
+    if (clip_options.tracker_threads <= 0)
+        clip_options.tracker_threads = std::max(1u, std::thread::hardware_concurrency() / num_workers);
+    if (clip_options.detection_threads <= 0)
+        clip_options.detection_threads = std::max(1u, std::thread::hardware_concurrency() / num_workers);
+
+    std::vector<clipReport> reports(clips.size());
+    int64 start_ticks = cv::getTickCount();
+
+    workerPool pool(num_workers);
+    pool.parallel_for(static_cast<int>(clips.size()), [&](int c) {
+        videoHandler handler(clips[c]);
+        if (!handler.errors)
+            handler.process_video(clip_options);
+
+        reports[c].name = clips[c];
+        reports[c].mAP = handler.mAP;
+        reports[c].mIoU = handler.mIoU;
+        reports[c].frames = handler.frames_processed;
+        reports[c].elapsed_s = handler.elapsed_s;
+        reports[c].errors = handler.errors;
+    });
+
+    double elapsed_s = (cv::getTickCount() - start_ticks) / cv::getTickFrequency();
+    print_reports(reports, elapsed_s);
+
+    for (const clipReport& report : reports) {
+        if (report.errors)
+            return false;
+    }
+    return true;
+}
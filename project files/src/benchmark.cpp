@@ -0,0 +1,438 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: benchmark.cpp
+    DESCRIPTION: Implements the benchmarks of the processing stages on the clips of the dataset.
+
+    FUNCTIONS:
+    - bool load_groundtruth(...): Loads the boxes and the classes of a groundtruth file.
+    - double end_position_error(...): Distance between a tracked center and the nearest groundtruth center of the same class.
+    - trackerBenchmark run_tracker(...): Runs a single backend on a single clip.
+    - std::vector<trackerBenchmark> benchmark_trackers(...): Runs every given tracker backend on every given clip and returns the results.
+    - void print_tracker_benchmark(...): Prints the results per clip and the average of every backend.
+    - double hull_distance(...): Max distance of the vertexes of a hull from another hull.
+    - double time_table(...): Mean time of a table detection on a frame.
+    - std::vector<tableBenchmark> benchmark_table(...): Runs both table segmentation paths on the first frame of every given clip.
+    - void print_table_benchmark(...): Prints the results per clip and the overall speed-up.
+    - double time_balls(...): Mean time of a ball detection on a frame.
+    - int groundtruth_hits(...): Number of groundtruth boxes containing a detected center.
+    - std::vector<circleBenchmark> benchmark_circles(...): Runs the ball detection with both circle detectors on the first frame of every given clip.
+    - void print_circle_benchmark(...): Prints the results per clip, the overall speed-up and recall.
+    - bool same_pairs(...): Whether an assignment matches the expected (track, detection) pairs.
+    - bool check_assignment(): Runs the detection-to-track assignment on small fixed cases and prints the outcome of each one.
+*/
+
+#include "benchmark.h"
+#include "trajectoryTracking.h"
+#include "table.h"
+#include "ballDetection.h"
+#include "frameContext.h"
+#include "ballAssignment.h"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+static bool load_groundtruth(const std::string& path, std::vector<cv::Rect>& boxes, std::vector<int>& classes){
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << "." << std::endl;
+        return false;
+    }
+
+    // One line per ball: x y w h class
+    int x, y, w, h, c;
+    while (file >> x >> y >> w >> h >> c) {
+        boxes.push_back(cv::Rect(x, y, w, h));
+        classes.push_back(c);
+    }
+    return true;
+}
+
+
+static double end_position_error(const cv::Point2f& center, int ball_class, const std::vector<cv::Rect>& boxes, const std::vector<int>& classes){
+    double best = std::numeric_limits<double>::max();
+    for (size_t j = 0; j < boxes.size(); ++j) {
+        if (classes[j] != ball_class)
+            continue;
+        cv::Point2f true_center(boxes[j].x + boxes[j].width / 2.0f, boxes[j].y + boxes[j].height / 2.0f);
+        best = std::min(best, static_cast<double>(cv::norm(center - true_center)));
+    }
+    return best;
+}
+
+
+static trackerBenchmark run_tracker(const std::string& clip, trackerBackend backend, const processingOptions& options){
+
+    trackerBenchmark result;
+    result.clip = clip;
+    result.backend = backend;
+    result.frames = 0;
+    result.balls = 0;
+    result.lost = 0;
+    result.elapsed_s = 0.0;
+    result.end_error = 0.0;
+    result.errors = true;
+
+    std::string folder_path = "../res/Dataset/" + clip;
+    std::vector<cv::Rect> first_boxes, last_boxes;
+    std::vector<int> first_classes, last_classes;
+    if (!load_groundtruth(folder_path + "/bounding_boxes/frame_first_bbox.txt", first_boxes, first_classes) ||
+        !load_groundtruth(folder_path + "/bounding_boxes/frame_last_bbox.txt", last_boxes, last_classes))
+        return result;
+
+    cv::VideoCapture capture(folder_path + "/" + clip + ".mp4");
+    cv::Mat frame;
+    if (!capture.isOpened() || !capture.read(frame)) {
+        std::cerr << "Error: Could not open the video of " << clip << "." << std::endl;
+        return result;
+    }
+
+    trajectoryTracker tracker;
+    tracker.set_backend(backend);
+    tracker.set_thread_budget(options.tracker_threads);
+    tracker.set_motion_threshold(options.motion_threshold);
+    tracker.verbose = false;
+    tracker.reserve_history(static_cast<size_t>(capture.get(cv::CAP_PROP_FRAME_COUNT)));
+
+    cv::TickMeter timer;
+    timer.start();
+    tracker.initializeTrackers(frame, first_boxes);
+    timer.stop();
+
+    int updates = 0;
+    while (capture.read(frame)) {
+        timer.start();
+        tracker.updateTrackers(frame);
+        timer.stop();
+        updates++;
+    }
+
+    // A ball is still tracked if its trajectory reaches the last frame
+    double tot_error = 0.0;
+    int found = 0;
+    for (size_t i = 0; i < tracker.num_trajectories(); ++i) {
+        trajectoryView trajectory = tracker.trajectory(i);
+        if (trajectory.empty() || trajectory.frames[trajectory.size() - 1] != updates) {
+            result.lost++;
+            continue;
+        }
+        tot_error += end_position_error(trajectory.back(), first_classes[i], last_boxes, last_classes);
+        found++;
+    }
+
+    result.frames = updates + 1;
+    result.balls = static_cast<int>(first_boxes.size());
+    result.elapsed_s = timer.getTimeSec();
+    result.end_error = found > 0 ? tot_error / found : 0.0;
+    result.errors = false;
+    return result;
+}
+
+
+std::vector<trackerBenchmark> benchmark_trackers(const std::vector<std::string>& clips, const std::vector<trackerBackend>& backends, const processingOptions& options){
+
+    std::vector<trackerBenchmark> results;
+    for (const std::string& clip : clips) {
+        for (trackerBackend backend : backends) {
+            if (options.verbose)
+                std::cout << "Benchmarking " << trackerBackendName(backend) << " on " << clip << "..." << std::endl;
+            results.push_back(run_tracker(clip, backend, options));
+        }
+    }
+    return results;
+}
+
+
+void print_tracker_benchmark(const std::vector<trackerBenchmark>& results, const std::vector<trackerBackend>& backends){
+
+    std::cout << "---TRACKER BENCHMARK---" << std::endl;
+    std::cout << std::left << std::setw(16) << "clip" << std::setw(8) << "tracker"
+              << std::right << std::setw(8) << "frames" << std::setw(8) << "balls" << std::setw(8) << "lost"
+              << std::setw(10) << "time[s]" << std::setw(10) << "fps" << std::setw(12) << "error[px]" << std::endl;
+
+    for (const trackerBenchmark& result : results) {
+        std::cout << std::left << std::setw(16) << result.clip << std::setw(8) << trackerBackendName(result.backend) << std::right;
+        if (result.errors) {
+            std::cout << "  ERROR" << std::endl;
+            continue;
+        }
+        double fps = result.elapsed_s > 0 ? result.frames / result.elapsed_s : 0.0;
+        std::cout << std::setw(8) << result.frames << std::setw(8) << result.balls << std::setw(8) << result.lost
+                  << std::fixed << std::setprecision(2) << std::setw(10) << result.elapsed_s
+                  << std::setprecision(1) << std::setw(10) << fps << std::setprecision(2) << std::setw(12) << result.end_error << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+
+    // Average of every backend over the clips
+    std::cout << "---AVERAGE-------------" << std::endl;
+    for (trackerBackend backend : backends) {
+        int frames = 0, balls = 0, lost = 0, clips = 0;
+        double elapsed_s = 0.0, error = 0.0;
+        for (const trackerBenchmark& result : results) {
+            if (result.backend != backend || result.errors)
+                continue;
+            frames += result.frames;
+            balls += result.balls;
+            lost += result.lost;
+            elapsed_s += result.elapsed_s;
+            error += result.end_error;
+            clips++;
+        }
+        std::cout << std::left << std::setw(8) << trackerBackendName(backend) << std::right << std::fixed << std::setprecision(1)
+                  << " fps=" << (elapsed_s > 0 ? frames / elapsed_s : 0.0)
+                  << " lost=" << lost << "/" << balls
+                  << std::setprecision(2) << " error=" << (clips > 0 ? error / clips : 0.0) << " px" << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+}
+
+
+static double hull_distance(const std::vector<cv::Point>& from, const std::vector<cv::Point>& to){
+    double max_distance = 0.0;
+    for (const cv::Point& point : from)
+        max_distance = std::max(max_distance, std::abs(cv::pointPolygonTest(to, cv::Point2f(point), true)));
+    return max_distance;
+}
+
+
+static double time_table(tableDetector& table, frameContext& context, const cv::Mat& frame, int repeats){
+    cv::TickMeter timer;
+    for (int r = 0; r < repeats; ++r) {
+        context.reset(frame);
+        timer.start();
+        table.find_table(context);
+        timer.stop();
+    }
+    return timer.getTimeMilli() / repeats;
+}
+
+
+std::vector<tableBenchmark> benchmark_table(const std::vector<std::string>& clips, int repeats){
+
+    std::vector<tableBenchmark> results;
+    for (const std::string& clip : clips) {
+        tableBenchmark result;
+        result.clip = clip;
+        result.default_ms = 0.0;
+        result.fused_ms = 0.0;
+        result.diff_pixels = 0;
+        result.iou = 0.0;
+        result.hull_distance = 0.0;
+        result.errors = true;
+
+        cv::VideoCapture capture("../res/Dataset/" + clip + "/" + clip + ".mp4");
+        cv::Mat frame;
+        if (!capture.isOpened() || !capture.read(frame)) {
+            std::cerr << "Error: Could not open the video of " << clip << "." << std::endl;
+            results.push_back(result);
+            continue;
+        }
+
+        frameContext context;
+        tableDetector default_table;
+        tableDetector fused_table;
+        fused_table.fused = true;
+
+        result.default_ms = time_table(default_table, context, frame, repeats);
+        result.fused_ms = time_table(fused_table, context, frame, repeats);
+
+        // Difference between the outputs
+        cv::Mat diff;
+        cv::compare(default_table.seg_mask, fused_table.seg_mask, diff, cv::CMP_NE);
+        result.diff_pixels = cv::countNonZero(diff);
+        int union_area = cv::countNonZero(default_table.seg_mask | fused_table.seg_mask);
+        int inter_area = cv::countNonZero(default_table.seg_mask & fused_table.seg_mask);
+        result.iou = union_area > 0 ? static_cast<double>(inter_area) / union_area : 1.0;
+        result.hull_distance = std::max(hull_distance(default_table.hull, fused_table.hull), hull_distance(fused_table.hull, default_table.hull));
+        result.errors = false;
+        results.push_back(result);
+    }
+    return results;
+}
+
+
+void print_table_benchmark(const std::vector<tableBenchmark>& results){
+
+    std::cout << "---TABLE BENCHMARK-----" << std::endl;
+    std::cout << std::left << std::setw(16) << "clip"
+              << std::right << std::setw(12) << "default[ms]" << std::setw(10) << "fused[ms]" << std::setw(10) << "speed-up"
+              << std::setw(12) << "diff[px]" << std::setw(8) << "IoU" << std::setw(10) << "hull[px]" << std::endl;
+
+    double tot_default = 0.0, tot_fused = 0.0;
+    for (const tableBenchmark& result : results) {
+        std::cout << std::left << std::setw(16) << result.clip << std::right;
+        if (result.errors) {
+            std::cout << "  ERROR" << std::endl;
+            continue;
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(12) << result.default_ms << std::setw(10) << result.fused_ms
+                  << std::setw(10) << (result.fused_ms > 0 ? result.default_ms / result.fused_ms : 0.0)
+                  << std::setw(12) << result.diff_pixels << std::setprecision(4) << std::setw(8) << result.iou
+                  << std::setprecision(1) << std::setw(10) << result.hull_distance << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+        tot_default += result.default_ms;
+        tot_fused += result.fused_ms;
+    }
+
+    std::cout << "Overall speed-up: " << (tot_fused > 0 ? tot_default / tot_fused : 0.0) << "x" << std::endl;
+}
+
+
+static double time_balls(ballDetector& detector, frameContext& context, const cv::Mat& frame, const tableDetector& table, int repeats){
+    cv::TickMeter timer;
+    for (int r = 0; r < repeats; ++r) {
+        context.reset(frame);
+        timer.start();
+        detector.detectBalls(context, table.seg_mask, table.corners);
+        timer.stop();
+    }
+    return timer.getTimeMilli() / repeats;
+}
+
+
+static int groundtruth_hits(const std::vector<cv::Point2f>& centers, const std::vector<cv::Rect>& boxes){
+    int hits = 0;
+    for (const cv::Rect& box : boxes) {
+        for (const cv::Point2f& center : centers) {
+            if (box.contains(cv::Point(cvRound(center.x), cvRound(center.y)))) {
+                hits++;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+
+std::vector<circleBenchmark> benchmark_circles(const std::vector<std::string>& clips, int repeats){
+
+    std::vector<circleBenchmark> results;
+    for (const std::string& clip : clips) {
+        circleBenchmark result;
+        result.clip = clip;
+        result.hough_ms = 0.0;
+        result.distance_ms = 0.0;
+        result.hough_balls = 0;
+        result.distance_balls = 0;
+        result.groundtruth = 0;
+        result.hough_hits = 0;
+        result.distance_hits = 0;
+        result.errors = true;
+
+        std::string folder_path = "../res/Dataset/" + clip;
+        std::vector<cv::Rect> boxes;
+        std::vector<int> classes;
+        if (!load_groundtruth(folder_path + "/bounding_boxes/frame_first_bbox.txt", boxes, classes)) {
+            results.push_back(result);
+            continue;
+        }
+
+        cv::VideoCapture capture(folder_path + "/" + clip + ".mp4");
+        cv::Mat frame;
+        if (!capture.isOpened() || !capture.read(frame)) {
+            std::cerr << "Error: Could not open the video of " << clip << "." << std::endl;
+            results.push_back(result);
+            continue;
+        }
+
+        frameContext context;
+        context.reset(frame);
+        tableDetector table;
+        table.find_table(context);
+
+        ballDetector hough_detector;
+        ballDetector distance_detector;
+        distance_detector.distance_circles = true;
+
+        result.hough_ms = time_balls(hough_detector, context, frame, table, repeats);
+        result.distance_ms = time_balls(distance_detector, context, frame, table, repeats);
+
+        result.hough_balls = static_cast<int>(hough_detector.centers.size());
+        result.distance_balls = static_cast<int>(distance_detector.centers.size());
+        result.groundtruth = static_cast<int>(boxes.size());
+        result.hough_hits = groundtruth_hits(hough_detector.centers, boxes);
+        result.distance_hits = groundtruth_hits(distance_detector.centers, boxes);
+        result.errors = false;
+        results.push_back(result);
+    }
+    return results;
+}
+
+
+void print_circle_benchmark(const std::vector<circleBenchmark>& results){
+
+    std::cout << "---CIRCLE BENCHMARK----" << std::endl;
+    std::cout << std::left << std::setw(16) << "clip"
+              << std::right << std::setw(10) << "hough[ms]" << std::setw(14) << "distance[ms]" << std::setw(10) << "speed-up"
+              << std::setw(8) << "truth" << std::setw(14) << "hough hit/n" << std::setw(16) << "distance hit/n" << std::endl;
+
+    double tot_hough = 0.0, tot_distance = 0.0;
+    int truth = 0, hough_hits = 0, distance_hits = 0;
+    for (const circleBenchmark& result : results) {
+        std::cout << std::left << std::setw(16) << result.clip << std::right;
+        if (result.errors) {
+            std::cout << "  ERROR" << std::endl;
+            continue;
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(10) << result.hough_ms << std::setw(14) << result.distance_ms
+                  << std::setw(10) << (result.distance_ms > 0 ? result.hough_ms / result.distance_ms : 0.0)
+                  << std::setw(8) << result.groundtruth
+                  << std::setw(14) << (std::to_string(result.hough_hits) + "/" + std::to_string(result.hough_balls))
+                  << std::setw(16) << (std::to_string(result.distance_hits) + "/" + std::to_string(result.distance_balls)) << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+        tot_hough += result.hough_ms;
+        tot_distance += result.distance_ms;
+        truth += result.groundtruth;
+        hough_hits += result.hough_hits;
+        distance_hits += result.distance_hits;
+    }
+
+    std::cout << "Overall speed-up: " << (tot_distance > 0 ? tot_hough / tot_distance : 0.0) << "x" << std::endl;
+    std::cout << "Recall: hough " << hough_hits << "/" << truth << ", distance " << distance_hits << "/" << truth << std::endl;
+}
+
+
+static bool same_pairs(const std::vector<assignmentPair>& result, const std::vector<std::pair<size_t, size_t>>& expected){
+    if (result.size() != expected.size())
+        return false;
+    for (size_t k = 0; k < result.size(); ++k) {
+        if (result[k].track != expected[k].first || result[k].detection != expected[k].second)
+            return false;
+    }
+    return true;
+}
+
+bool check_assignment(){
+    std::vector<double> gates = {40.0, 40.0};
+    bool ok = true;
+
+    // Two balls, detections in the other order
+    std::vector<cv::Point2f> tracks = {cv::Point2f(100, 100), cv::Point2f(200, 100)};
+    std::vector<cv::Point2f> detections = {cv::Point2f(205, 102), cv::Point2f(98, 99)};
+    bool passed = same_pairs(assignDetections(tracks, detections, gates), {{0, 1}, {1, 0}});
+    std::cout << "assignment, two balls: " << (passed ? "ok" : "FAILED") << std::endl;
+    ok = ok && passed;
+
+    // A track far away from the table: same pairs, and the grid stays small
+    tracks = {cv::Point2f(100, 100), cv::Point2f(-1e6f, -1e6f), cv::Point2f(200, 100)};
+    passed = same_pairs(assignDetections(tracks, detections, gates), {{0, 1}, {2, 0}});
+    std::cout << "assignment, far away track: " << (passed ? "ok" : "FAILED") << std::endl;
+    ok = ok && passed;
+
+    // Resync after a pocketing: the pocketed track lies on a detection but is left out
+    tracks = {cv::Point2f(100, 100), cv::Point2f(110, 100), cv::Point2f(200, 100)};
+    detections = {cv::Point2f(100, 100), cv::Point2f(195, 100)};
+    std::vector<bool> pocketed = {true, false, false};
+    passed = same_pairs(assignDetections(tracks, detections, gates, pocketed), {{1, 0}, {2, 1}});
+    std::cout << "assignment, pocketed track: " << (passed ? "ok" : "FAILED") << std::endl;
+    ok = ok && passed;
+
+    // Every track pocketed: nothing to assign
+    pocketed = {true, true, true};
+    passed = assignDetections(tracks, detections, gates, pocketed).empty();
+    std::cout << "assignment, all pocketed: " << (passed ? "ok" : "FAILED") << std::endl;
+    ok = ok && passed;
+
+    return ok;
+}
@@ -0,0 +1,99 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: frameContext.cpp
+    DESCRIPTION: Implements the frameContext class, which holds the current frame and caches its color conversions for all the detection stages.
+
+    CLASS: frameContext
+
+    METHODS:
+    - frameContext(): Constructor to initialize an empty context.
+    - void reset(...): Starts a new frame. The cached conversions are dropped, their buffers are kept for the next frame.
+    - const cv::Mat& bgr(): The current frame.
+    - cv::Mat hsv(...) / lab(...) / gray(...): The frame (or a region of it) in HSV, Lab or grayscale. Converted on first use, then served from the cache.
+    - cv::Mat scaled(...): A region of the frame (BGR) resized by the given factor, e.g. the input of the trackers. Resized on first use, then served from the cache.
+    - cv::Mat convert(...): Serves a region of a plane, converting it if not covered yet.
+    - void print_stats(): Prints the hits and misses of the cache since the start.
+*/
+
+#include "frameContext.h"
+
+frameContext::frameContext(){
+    this->hsv_plane.valid = false;
+    this->lab_plane.valid = false;
+    this->gray_plane.valid = false;
+    this->scaled_plane.valid = false;
+    this->scaled_factor = 1.0;
+    this->hits = 0;
+    this->misses = 0;
+}
+
+void frameContext::reset(const cv::Mat& frame){
+    this->frame = frame;
+    this->hsv_plane.valid = false;
+    this->lab_plane.valid = false;
+    this->gray_plane.valid = false;
+    this->scaled_plane.valid = false;
+}
+
+const cv::Mat& frameContext::bgr() const{
+    return this->frame;
+}
+
+cv::Mat frameContext::convert(colorPlane& plane, int code, const cv::Rect& roi){
+    cv::Rect frameRect(0, 0, this->frame.cols, this->frame.rows);
+    cv::Rect area = roi.empty() ? frameRect : (roi & frameRect);
+
+    if (plane.valid && (plane.area & area) == area) {
+        this->hits++;
+        return plane.data(area - plane.area.tl());
+    }
+
+    // Convert the union of what is already covered and what is asked
+    this->misses++;
+    if (plane.valid)
+        area |= plane.area;
+    cv::cvtColor(this->frame(area), plane.data, code);
+    plane.area = area;
+    plane.valid = true;
+
+    cv::Rect asked = roi.empty() ? frameRect : (roi & frameRect);
+    return plane.data(asked - area.tl());
+}
+
+cv::Mat frameContext::hsv(const cv::Rect& roi){
+    return this->convert(this->hsv_plane, cv::COLOR_BGR2HSV, roi);
+}
+
+cv::Mat frameContext::lab(const cv::Rect& roi){
+    return this->convert(this->lab_plane, cv::COLOR_BGR2Lab, roi);
+}
+
+cv::Mat frameContext::gray(const cv::Rect& roi){
+    return this->convert(this->gray_plane, cv::COLOR_BGR2GRAY, roi);
+}
+
+cv::Mat frameContext::scaled(const cv::Rect& roi, double scale){
+    cv::Rect frameRect(0, 0, this->frame.cols, this->frame.rows);
+    cv::Rect area = roi.empty() ? frameRect : (roi & frameRect);
+
+    if (this->scaled_plane.valid && this->scaled_plane.area == area && this->scaled_factor == scale) {
+        this->hits++;
+        return this->scaled_plane.data;
+    }
+
+    this->misses++;
+    cv::resize(this->frame(area), this->scaled_plane.data, cv::Size(), scale, scale, cv::INTER_AREA);
+    this->scaled_plane.area = area;
+    this->scaled_plane.valid = true;
+    this->scaled_factor = scale;
+    return this->scaled_plane.data;
+}
+
+void frameContext::print_stats() const{
+    long long tot = this->hits + this->misses;
+    std::cout << "Color conversions: " << this->misses << " computed, " << this->hits << " served from cache";
+    if (tot > 0)
+        std::cout << " (" << 100.0 * this->hits / tot << "% hits)";
+    std::cout << std::endl;
+}
@@ -8,18 +8,30 @@
     - class frameHandler: Class for handling frames, including detecting tables and balls, initializing and updating trackers, and projecting ball trajectories.
 
     MAIN FUNCTIONS:
-    - frameHandler(): Constructor to initialize the frameHandler object.
-    - void detect_table(...): Detects the table in the given frame.
-    - void detect_balls(...): Detects balls in the given frame.
-    - void detect_balls_final(...): Detects balls in the final frame and matches them with tracker centers.
+    - frameHandler(...): Constructor to initialize the frameHandler object with the processing options.
+    - void begin_frame(...): Starts the analysis of a new frame: the detection steps below work on it, sharing its color conversions through the frame context.
+    - void detect_table(): Detects the table in the current frame. The detection runs again only if the camera moved since the last calibration.
+    - void detect_balls(): Detects balls in the current frame. With track classification the confident tracks are passed to the detector, which does not analyze their balls again.
     - void initializeTrackers(...): Initializes trackers for the detected balls.
     - void updateTrackers(...): Updates the trackers with the current frame.
-    - cv::Mat draw_frame(...): Draws the borders of the table on the given frame.
-    - void project(...): Projects the ball trajectories on the given frame.
+    - void print_tracker_stats(): Prints how many tracker updates the motion gating skipped, the final state of the tracks, the resyncs and restarted trackers, the hits of the color conversion cache, the share of incremental ball detections and the use of the track classifier.
+    - bool detect_rest(...): Feeds the frame to the shot segmentation. Returns true when the balls just came to rest after a shot.
+    - std::vector<int> center_ids(): Classes of the balls found by the trackers in the last frame, aligned with the tracker centers.
+    - cv::Mat tracker_input(...): Frame given to the trackers: the whole frame, or with `tracker_scale` < 1 the bounding box of the table (plus `TRACKER_MARGIN`) downscaled, cached in the frame context.
+    - void resync_trackers(...): Matches the last detection with the trackers (optimal assignment, pocketed balls excluded), restarts the matched trackers on the detected boxes and updates their classes (votes of the track classifier, if enabled). Unless all of them must be restarted (balls at rest), only the trackers that drifted more than `RESYNC_DRIFT` of the ball box, or are not active, are restarted.
+    - const shotSegmenter& finish_shots(...): Closes the shot timeline at the end of the clip and returns it.
+    - void reserve_history(...): Reserves the trajectory storage for the given number of frames.
+    - stageProfiler* stage_profiler(): Latency histograms of the stages of this run, also fed by the decode and encode steps of `videoHandler`.
+    - void skip_frames(...): Tells the trackers that the given number of frames were not analyzed (temporal stride).
+    - double max_displacement(): Largest move of a tracked ball between the last two analyzed frames, in px.
+    - bool save_trajectories(...): Writes the trajectory of every ball to a text file, one line per ball and frame, interpolated positions flagged.
+    - void save_state(...): Copies into a `renderState` everything the drawing steps need from the analysis of the current frame. Only the trajectory points added since the previous state with a homography are copied.
+    - void draw_frame(...): Draws the borders of the table on the given frame.
+    - cv::Mat project(...): Projects the ball trajectories on the given frame.
 
     ADDITIONAL FUNCTIONS:
-    - save_table_corners(): Stores the corners of the detected table for later use.
-    - save_ids(): Stores the IDs of the detected balls for later use.
+    - save_table_corners(): Stores the corners of the detected table for later use. They are refreshed when a detection frame (first, last, rest state, --redetect-every) finds that the camera moved: the frames in between keep the old corners. The pockets of the tracker follow every new calibration.
+    - save_ids(): Stores the IDs of the detected balls for later use. With track classification the IDs come from the track classifier, started on the detected balls.
 
     EXAMPLES:
     - Input: A frame from a video feed with a table and balls visible.
@@ -28,53 +40,279 @@
 
 #include "frameHandler.h"
 #include "table.h"
+#include "tableCalibration.h"
 #include "trajectoryTracking.h"
 #include "trajectoryProjection.h"
+#include <algorithm>
+#include <fstream>
 
-frameHandler::frameHandler(){
+frameHandler::frameHandler(const processingOptions& options){
     this->table = tableDetector();
+    this->table.fused = options.fused_table;
+    this->table.pyramid_levels = options.table_pyramid_levels;
+    this->table.quad_corners = options.quad_corners;
+    this->calibration = tableCalibration();
     this->detector = ballDetector();
+    this->detector.distance_circles = options.distance_circles;
+    this->detector.set_thread_budget(options.detection_threads);
+    this->detector.incremental = options.incremental_detection;
     this->tracker = trajectoryTracker();
+    this->tracker.set_backend(options.tracker_backend);
+    this->tracker.set_thread_budget(options.tracker_threads);
+    this->tracker.set_motion_threshold(options.motion_threshold);
+    this->tracker.verbose = options.verbose;
+    this->tracker_scale = options.tracker_scale > 0.0 && options.tracker_scale < 1.0 ? options.tracker_scale : 1.0;
+    this->tracker_table_id = -1;
+    this->timings = std::make_shared<stageProfiler>();
     this->projecter = trajectoryProjecter();
+    this->shots = shotSegmenter();
+    this->shots_table_id = -1;
+    this->track_classes = options.track_classification;
+    this->resyncs = 0;
+    this->restarted = 0;
 }
 
-void frameHandler::detect_table(const cv::Mat& frame){
-    table.find_table(frame);
+void frameHandler::begin_frame(const cv::Mat& frame){
+    context.reset(frame);
+}
+
+void frameHandler::detect_table(){
+    TIME_STAGE(this->timings.get(), STAGE_DETECT_TABLE);
+    const cv::Mat& frame = context.bgr();
+
+    // Fixed camera: keep the cached geometry
+    if (calibration.valid && !calibration.camera_moved(frame))
+        return;
+
+    table.find_table(context);
+    calibration.calibrate(frame, table, trajectoryProjecter::minimapCorners());
+    tracker.set_pockets(calibration.corners);
     //--Debug  std::cout << "table_color: H=" << table.hue_color << " BGR=" << table.bgr_color << std::endl;
+
+    // Corners already saved belong to the old view
+    if (!this->table_corners.empty())
+        this->save_table_corners();
 }
 
 void frameHandler::save_table_corners(){
-    this->table_corners = table.corners;
+    this->table_corners = calibration.corners;
 }
 
-void frameHandler::detect_balls(const cv::Mat& frame){
-    detector.detectBalls(frame, table.seg_mask, this->table_corners);
+void frameHandler::detect_balls(){
+    TIME_STAGE(this->timings.get(), STAGE_DETECT_BALLS);
+    // Confident tracks: their class is settled, their patterns are not analyzed again
+    std::vector<cv::Point2f> known_centers;
+    std::vector<BallPattern> known_patterns;
+    if (this->track_classes && classes.size() == tracker.num_trajectories()) {
+        for (size_t i = 0; i < classes.size(); ++i) {
+            if (!classes.confident(i))
+                continue;
+            cv::Rect last = tracker.last_bbox(i);
+            known_centers.push_back(cv::Point2f(last.x + last.width / 2.0f, last.y + last.height / 2.0f));
+            known_patterns.push_back(classes.mean_pattern(i));
+        }
+    }
+    detector.set_known_balls(known_centers, known_patterns);
+
+    detector.detectBalls(context, calibration.seg_mask, this->table_corners);
     this->bbox_data = detector.bbox_data;
     this->classification_res = detector.classification_res;
 }
 
-void frameHandler::detect_balls_final(const cv::Mat& frame){
-    detector.detectBallsFinalFrame(frame, table.seg_mask, tracker.centers, this->starting_ids, this->table_corners);
-    this->bbox_data = detector.bbox_data;
-    this->classification_res = detector.classification_res;
+std::vector<int> frameHandler::center_ids() const{
+    // Only the balls found in the last frame have a center
+    std::vector<int> ids;
+    ids.reserve(tracker.center_tracks.size());
+    for (size_t track : tracker.center_tracks)
+        ids.push_back(track < this->starting_ids.size() ? this->starting_ids[track] : 0);
+    return ids;
+}
+
+cv::Mat frameHandler::tracker_input(const cv::Mat& frame){
+    if (this->tracker_scale == 1.0)
+        return frame;
+
+    // The region follows the table: it changes only with a new calibration
+    if (this->tracker_table_id != calibration.id || this->tracker_crop.empty()) {
+        cv::Rect frameRect(0, 0, frame.cols, frame.rows);
+        cv::Rect tableRect = calibration.valid ? cv::boundingRect(calibration.seg_mask) : cv::Rect();
+        this->tracker_crop = frameRect;
+        if (!tableRect.empty())
+            this->tracker_crop = cv::Rect(tableRect.x - TRACKER_MARGIN, tableRect.y - TRACKER_MARGIN, tableRect.width + 2*TRACKER_MARGIN, tableRect.height + 2*TRACKER_MARGIN) & frameRect;
+        this->tracker_table_id = calibration.id;
+        tracker.set_input_transform(cv::Point2f(this->tracker_crop.tl()), this->tracker_scale);
+    }
+    return context.scaled(this->tracker_crop, this->tracker_scale);
 }
 
 void frameHandler::initializeTrackers(const cv::Mat& frame){
-    tracker.initializeTrackers(frame, detector.balls);      
+    TIME_STAGE(this->timings.get(), STAGE_INIT_TRACKERS);
+    tracker.initializeTrackers(this->tracker_input(frame), detector.balls);      
 }
 
 void frameHandler::save_ids(){
-    this->starting_ids = detector.id_balls;
+    if (!this->track_classes) {
+        this->starting_ids = detector.id_balls;
+        return;
+    }
+
+    // One track per detected ball, the first detection is the first vote
+    classes.reset(detector.patterns.size());
+    for (size_t i = 0; i < detector.patterns.size(); ++i)
+        classes.observe(i, detector.patterns[i]);
+    this->starting_ids = classes.labels();
+}
+
+bool frameHandler::detect_rest(const cv::Mat& frame, int frame_index){
+    if (!calibration.valid)
+        return false;
+
+    // New table view: the motion is measured on the new mask
+    if (this->shots_table_id != calibration.id) {
+        shots.set_table(calibration.seg_mask);
+        this->shots_table_id = calibration.id;
+    }
+
+    return shots.update(frame, frame_index) == SHOT_END;
+}
+
+void frameHandler::resync_trackers(const cv::Mat& frame, bool restart_all){
+    size_t num_trackers = tracker.num_trajectories();
+    const std::vector<cv::Rect>& detections = detector.balls;
+
+    // Last centers of the trackers (pocketed balls left out of the assignment) and detected centers
+    std::vector<cv::Point2f> tracked(num_trackers), detected(detections.size());
+    std::vector<bool> pocketed(num_trackers);
+    for (size_t i = 0; i < num_trackers; ++i) {
+        cv::Rect last = tracker.last_bbox(i);
+        tracked[i] = cv::Point2f(last.x + last.width / 2.0f, last.y + last.height / 2.0f);
+        pocketed[i] = tracker.state(i) == TRACK_POCKETED;
+    }
+    std::vector<double> gates(detections.size());
+    for (size_t j = 0; j < detections.size(); ++j) {
+        detected[j] = cv::Point2f(detections[j].x + detections[j].width / 2.0f, detections[j].y + detections[j].height / 2.0f);
+        gates[j] = 2.0 * std::max(detections[j].width, detections[j].height);
+    }
+
+    // Optimal assignment: every tracker and every detection used once
+    std::vector<cv::Rect> boxes(num_trackers);
+    for (const assignmentPair& pair : assignDetections(tracked, detected, gates, pocketed)) {
+        const cv::Rect& box = detections[pair.detection];
+
+        // Periodic re-detection: only the trackers that drifted (or are not active) are restarted
+        bool drifted = pair.distance > RESYNC_DRIFT * std::max(box.width, box.height);
+        if (restart_all || drifted || tracker.state(pair.track) != TRACK_ACTIVE) {
+            boxes[pair.track] = box;
+            this->restarted++;
+        }
+
+        if (pair.track >= this->starting_ids.size())
+            continue;
+        if (!this->track_classes) {
+            this->starting_ids[pair.track] = detector.id_balls[pair.detection];
+            continue;
+        }
+        if (classes.confident(pair.track))
+            classes.skipped++;
+        else
+            classes.observe(pair.track, detector.patterns[pair.detection]);
+        this->starting_ids[pair.track] = classes.label(pair.track);
+    }
+    this->resyncs++;
+
+    tracker.resyncTrackers(this->tracker_input(frame), boxes);
+}
+
+const shotSegmenter& frameHandler::finish_shots(int last_frame){
+    shots.finish(last_frame);
+    return shots;
 }
 
 void frameHandler::updateTrackers(const cv::Mat& frame){
-    tracker.updateTrackers(frame);
+    TIME_STAGE(this->timings.get(), STAGE_UPDATE_TRACKERS);
+    tracker.updateTrackers(this->tracker_input(frame));
+}
+
+void frameHandler::print_tracker_stats() const{
+    const gatingStats& stats = tracker.gating_stats();
+    long long tot = stats.tot_updated + stats.tot_skipped;
+    std::cout << "Tracker updates: " << stats.tot_updated << " run, " << stats.tot_skipped << " skipped (still balls)";
+    if (tot > 0)
+        std::cout << ", " << 100.0 * stats.tot_skipped / tot << "% saved";
+    std::cout << std::endl;
+    trackCounts counts = tracker.track_counts();
+    std::cout << "Tracks: " << counts.active << " active, " << counts.lost << " lost, " << counts.pocketed << " pocketed, " << counts.retired << " retired" << std::endl;
+    std::cout << "Tracker resyncs: " << this->resyncs << ", " << this->restarted << " trackers restarted" << std::endl;
+    context.print_stats();
+    detector.print_stats();
+    if (this->track_classes)
+        classes.print_stats();
+}
+
+void frameHandler::reserve_history(int frames){
+    tracker.reserve_history(frames);
+}
+
+stageProfiler* frameHandler::stage_profiler() const{
+    return this->timings.get();
+}
+
+void frameHandler::skip_frames(int frames){
+    tracker.skipFrames(frames);
+}
+
+double frameHandler::max_displacement() const{
+    return tracker.max_displacement();
+}
+
+bool frameHandler::save_trajectories(const std::string& path) const{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << "." << std::endl;
+        return false;
+    }
+
+    file << "# frame ball class x y interpolated" << std::endl;
+    for (size_t i = 0; i < tracker.num_trajectories(); ++i) {
+        trajectoryView trajectory = tracker.trajectory(i);
+        int id = i < this->starting_ids.size() ? this->starting_ids[i] : 0;
+        for (size_t k = 0; k < trajectory.size(); ++k)
+            file << trajectory.frames[k] << " " << i << " " << id << " " << trajectory[k].x << " " << trajectory[k].y << " " << static_cast<int>(trajectory.interpolated[k]) << std::endl;
+    }
+    return true;
+}
+
+void frameHandler::save_state(renderState& state){
+    state.hull = calibration.hull;
+    state.corners = calibration.corners;
+    state.homography = calibration.homography;
+    state.centers = tracker.centers;
+    state.ids = this->center_ids();
+
+    // Without a homography the tails could not be drawn: keep them for the first state that has one
+    if (state.homography.empty()) {
+        state.trajectory_tails.clear();
+        return;
+    }
+
+    // The states are rendered in order, so each one carries only the new part of the trajectories
+    size_t num_trajectories = tracker.num_trajectories();
+    this->sent_points.resize(num_trajectories, 0);
+    state.trajectory_tails.resize(num_trajectories);
+    for (size_t i = 0; i < num_trajectories; ++i) {
+        trajectoryView trajectory = tracker.trajectory(i);
+        size_t first = this->sent_points[i] > 0 ? this->sent_points[i] - 1 : 0;
+        state.trajectory_tails[i].assign(trajectory.begin() + first, trajectory.end());
+        this->sent_points[i] = trajectory.size();
+    }
 }
 
-cv::Mat frameHandler::draw_frame(const cv::Mat& frame){
-    return table.draw_borders(frame);
+void frameHandler::draw_frame(const cv::Mat& frame, cv::Mat& w_borders_on, const renderState& state){
+    TIME_STAGE(this->timings.get(), STAGE_DRAW_FRAME);
+    tableDetector::draw_borders(frame, w_borders_on, state.hull, state.corners);
 }
 
-cv::Mat frameHandler::project(const cv::Mat& frame){
-    return projecter.projectBalls(frame, tracker.centers, tracker.trajectories, this->starting_ids, this->table_corners);
+cv::Mat frameHandler::project(const cv::Mat& frame, const renderState& state){
+    TIME_STAGE(this->timings.get(), STAGE_PROJECT);
+    return projecter.projectBalls(frame, state.centers, state.trajectory_tails, state.ids, state.homography);
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: frameSink.cpp
+    DESCRIPTION: Implements the interactive preview sink, the only place of the pipeline that calls HighGUI.
+
+    CLASSES:
+    - class previewSink: Interactive preview that shows the frames through HighGUI windows.
+
+    METHODS:
+    - previewSink(): Constructor of the preview sink.
+    - void show_frame(...): Shows the processed frame and refreshes the window.
+    - void show_midstep(...): Shows bounding boxes and segmentation mask, and waits for a key press on the first and last frame.
+*/
+
+#include "frameSink.h"
+
+previewSink::previewSink(){
+}
+
+void previewSink::show_frame(const cv::Mat& ret_frame){
+    cv::namedWindow("frame_i"); cv::imshow("frame_i", ret_frame);
+    cv::waitKey(1);
+}
+
+void previewSink::show_midstep(const cv::Mat& bb_frame, const cv::Mat& mask, bool wait){
+    cv::namedWindow("bb"); cv::imshow("bb", bb_frame);
+    cv::namedWindow("mask"); cv::imshow("mask", mask);
+
+    if (wait){
+        std::cout << "Press any key to proceed..." << std::endl;
+        cv::waitKey(0);
+    }
+}
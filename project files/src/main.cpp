@@ -18,13 +18,55 @@
     USAGE:
     - Example: ./main game1_clip1 y
       This command runs the program on the folder "game1_clip1" with the flag to view the algorithm's mid-steps.
+    - Example: ./main game1_clip1 n --headless
+      Same processing without any window (no HighGUI call at all), e.g. on machines without a display. Wall time and fps are reported at the end.
+    - Example: ./main game1_clip1 n --shots
+      Detects the shots from the motion over the table and runs the ball detection again each time the balls come to rest, re-synchronizing the trackers. The shot timeline is printed and saved in build/output.
+    - Example: ./main game1_clip1 n --headless --pipeline --queue-size=8
+      Runs decode, analysis, render and encode as concurrent stages connected by queues of 8 frames.
+    - Example: ./main game1_clip1 n --tracker=ball
+      Tracks the balls with the purpose-built ball tracker instead of CSRT (csrt, kcf, mosse, ball).
+    - Example: ./main game1_clip1 n --motion-threshold=0
+      Updates every tracker on every frame. By default the update of a ball whose patch did not change (mean absolute gray difference below 3) is skipped.
+    - Example: ./main all n --benchmark-trackers
+      Runs every tracker backend on every clip from the groundtruth boxes of the first frame and prints fps, lost balls and end-position error of each one.
+    - Example: ./main all n --benchmark-table
+      Times the default and the fused table segmentation on the first frame of every clip and prints the difference between their masks and hulls. Add --fused-table to any run to use the fused path.
+    - Example: ./main game1_clip1 n --table-pyramid=2
+      Finds the table on a frame downscaled by 4 and refines only its borders and corners at full resolution.
+    - Example: ./main game1_clip1 n --quad-corners
+      Takes the table corners from a quadrilateral fitted on the hull of the table, refined on its contour, instead of the Hough lines. Always 4 corners.
+    - Example: ./main all n --benchmark-circles
+      Times the ball detection on the first frame of every clip with HoughCircles and with the distance transform detector, and prints the balls found by each one and how many groundtruth balls they hit. Add --distance-circles to any run to use the distance transform detector.
+    - Example: ./main game1_clip1 y --detection-threads=0
+      Runs the ball detection on overlapping tiles of the table, one thread per hardware thread. Useful with the mid-steps on, where the balls are detected on every frame.
+    - Example: ./main game1_clip1 y --incremental-detection
+      Detects the balls on every frame again only where the table changed since the previous detection, keeping the balls that did not move.
+    - Example: ./main game1_clip1 n --redetect-every=30
+      Detects the balls every 30 frames and restarts only the trackers that drifted from their ball. Combine with --incremental-detection to make the periodic detections cheap.
+    - Example: ./main game1_clip1 n --stride=4
+      Analyzes one frame every 4 (every frame again while a ball moves more than 12 px between two analyzed frames, see --stride-displacement=X) and interpolates the trajectories over the skipped frames. The output video and the trajectory file still have one entry per frame. Always runs sequentially.
+    - Example: ./main game1_clip1 n --tracker-scale=0.5
+      The trackers work on the bounding box of the table at half resolution. Useful on high resolution footage, where the balls are much bigger than the trackers need.
+    - Example: ./main game1_clip1 n --pipeline --timings-json
+      Prints p50/p90/p99/max of every stage at the end of the run (decode, table and ball detection, trackers, drawing, encode) and saves them as JSON next to the output video. Build with -DSTAGE_TIMERS=OFF to compile the timers out.
+    - Example: ./main game1_clip1 n --shots --track-classes
+      Every re-detection votes for the class of the matched tracks instead of replacing it, so the minimap colors stay stable. The balls of confident tracks are not analyzed again.
+    - Example: ./main all n --check-assignment
+      Runs the detection-to-track assignment of the re-detections on small fixed cases (including pocketed balls) and prints ok or FAILED for each one, without reading any clip.
+    - Example: ./main all n --jobs=4
+      Processes every clip found in res/Dataset at the same time on 4 workers (default: one per hardware thread), headless, and prints one table with mAP, mIoU, frames and fps of every clip.
 
     NOTES:
     - The program requires at least two command line arguments: the folder name and a flag to indicate whether to view the mid-steps of the algorithm.
+    - Optional arguments follow the two mandatory ones: --headless, --shots, --pipeline, --queue-size=N, --jobs=N, --tracker-threads=N, --tracker=NAME, --tracker-scale=X, --motion-threshold=X, --fused-table, --table-pyramid=N, --quad-corners, --distance-circles, --detection-threads=N, --incremental-detection, --redetect-every=K, --stride=N, --stride-displacement=X, --track-classes, --timings-json, --benchmark-trackers, --benchmark-table, --benchmark-circles, --check-assignment.
+    - Passing "all" as folder name runs the batch mode, which is always headless.
     - The program uses the videoHandler class to process the video and handles errors appropriately.
 */
 
 #include "videoHandler.h"
+#include "batchRunner.h"
+#include "benchmark.h"
 
 int main(int argc, char** argv) {
 
@@ -35,10 +77,148 @@ int main(int argc, char** argv) {
     }
     
     std::string folder_name = argv[1];
-    bool MIDSTEP_flag = (std::tolower(argv[2][0]) == 'y');
+    processingOptions options;
+    options.MIDSTEP_flag = (std::tolower(argv[2][0]) == 'y');
+
+    // Optional arguments
+    bool headless = false;
+    int jobs = 0;
+    bool benchmark = false;
+    bool benchmark_table_flag = false;
+    bool benchmark_circles_flag = false;
+    bool check_assignment_flag = false;
+    for (int a=3; a<argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--shots") {
+            options.shot_events = true;
+        } else if (arg == "--pipeline") {
+            options.pipelined = true;
+        } else if (arg.rfind("--queue-size=", 0) == 0) {
+            options.queue_capacity = std::max(1, std::atoi(arg.substr(13).c_str()));
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            jobs = std::max(1, std::atoi(arg.substr(7).c_str()));
+        } else if (arg.rfind("--tracker-threads=", 0) == 0) {
+            options.tracker_threads = std::max(0, std::atoi(arg.substr(18).c_str()));
+        } else if (arg.rfind("--tracker=", 0) == 0) {
+            if (!parseTrackerBackend(arg.substr(10), options.tracker_backend)) {
+                std::cerr << "Error: Unknown tracker " << arg.substr(10) << " (csrt, kcf, mosse, ball)" << std::endl;
+                return -1;
+            }
+        } else if (arg.rfind("--tracker-scale=", 0) == 0) {
+            double scale = std::atof(arg.substr(16).c_str());
+            options.tracker_scale = (scale > 0.0 && scale < 1.0) ? scale : 1.0;    // outside (0,1): full resolution
+        } else if (arg.rfind("--motion-threshold=", 0) == 0) {
+            options.motion_threshold = std::atof(arg.substr(19).c_str());
+        } else if (arg == "--benchmark-trackers") {
+            benchmark = true;
+        } else if (arg == "--fused-table") {
+            options.fused_table = true;
+        } else if (arg.rfind("--table-pyramid=", 0) == 0) {
+            options.table_pyramid_levels = std::max(0, std::atoi(arg.substr(16).c_str()));
+        } else if (arg == "--quad-corners") {
+            options.quad_corners = true;
+        } else if (arg == "--benchmark-table") {
+            benchmark_table_flag = true;
+        } else if (arg.rfind("--detection-threads=", 0) == 0) {
+            options.detection_threads = std::max(0, std::atoi(arg.substr(20).c_str()));
+        } else if (arg == "--incremental-detection") {
+            options.incremental_detection = true;
+        } else if (arg.rfind("--redetect-every=", 0) == 0) {
+            options.redetect_interval = std::max(0, std::atoi(arg.substr(17).c_str()));
+        } else if (arg.rfind("--stride=", 0) == 0) {
+            options.frame_stride = std::max(1, std::atoi(arg.substr(9).c_str()));
+        } else if (arg.rfind("--stride-displacement=", 0) == 0) {
+            options.stride_displacement = std::atof(arg.substr(22).c_str());
+        } else if (arg == "--timings-json") {
+            options.timings_json = true;
+        } else if (arg == "--track-classes") {
+            options.track_classification = true;
+        } else if (arg == "--distance-circles") {
+            options.distance_circles = true;
+        } else if (arg == "--benchmark-circles") {
+            benchmark_circles_flag = true;
+        } else if (arg == "--check-assignment") {
+            check_assignment_flag = true;
+        } else {
+            std::cerr << "Error: Unknown argument " << arg << std::endl;
+            return -1;
+        }
+    }
+
+    // Fixed cases of the detection-to-track assignment
+    if (check_assignment_flag)
+        return check_assignment() ? 0 : -1;
+
+    // Comparison of the default and of the fused table segmentation, on one clip or on the whole dataset
+    if (benchmark_table_flag) {
+        std::vector<std::string> clips;
+        if (folder_name == "all")
+            clips = find_clips("../res/Dataset");
+        else
+            clips.push_back(folder_name);
+        std::vector<tableBenchmark> results = benchmark_table(clips, 20);
+        print_table_benchmark(results);
+        for (const tableBenchmark& result : results) {
+            if (result.errors)
+                return -1;
+        }
+        return 0;
+    }
+
+    // Comparison of HoughCircles and of the distance transform detector, on one clip or on the whole dataset
+    if (benchmark_circles_flag) {
+        std::vector<std::string> clips;
+        if (folder_name == "all")
+            clips = find_clips("../res/Dataset");
+        else
+            clips.push_back(folder_name);
+        std::vector<circleBenchmark> results = benchmark_circles(clips, 20);
+        print_circle_benchmark(results);
+        for (const circleBenchmark& result : results) {
+            if (result.errors)
+                return -1;
+        }
+        return 0;
+    }
+
+    // Comparison of the tracker backends, on one clip or on the whole dataset
+    if (benchmark) {
+        std::vector<std::string> clips;
+        if (folder_name == "all")
+            clips = find_clips("../res/Dataset");
+        else
+            clips.push_back(folder_name);
+        std::vector<trackerBackend> backends = {TRACKER_CSRT, TRACKER_KCF, TRACKER_MOSSE, TRACKER_BALL};
+        std::vector<trackerBenchmark> results = benchmark_trackers(clips, backends, options);
+        print_tracker_benchmark(results, backends);
+        for (const trackerBenchmark& result : results) {
+            if (result.errors)
+                return -1;
+        }
+        return 0;
+    }
+
+    // Batch mode over the whole dataset
+    if (folder_name == "all") {
+        std::vector<std::string> clips = find_clips("../res/Dataset");
+        if (run_batch(clips, options, jobs)) {
+            std::cout << "Terminated without errors." << std::endl;
+            return 0;
+        }
+        std::cerr << "Process terminated due errors." << std::endl;
+        return -1;
+    }
 
     videoHandler handler = videoHandler(folder_name);
-    handler.process_video(MIDSTEP_flag);
+
+    // Interactive preview is attached only when a display is wanted
+    previewSink preview;
+    if (!headless){
+        handler.attach_sink(&preview);}
+
+    handler.process_video(options);
 
     if (handler.errors == false){
         std::cout << "Terminated without errors." << std::endl;
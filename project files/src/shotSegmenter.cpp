@@ -0,0 +1,132 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: shotSegmenter.cpp
+    DESCRIPTION: Implements the shotSegmenter class, which splits a clip into shots from the motion over the table.
+
+    CLASSES:
+    - class shotSegmenter: Motion energy over the table and rest/motion state machine.
+
+    MAIN FUNCTIONS:
+    - shotSegmenter(): Constructor to initialize the shotSegmenter object with the default thresholds.
+    - void set_table(...): Sets the table mask the motion is measured on. Called again when the table changes.
+    - shotEvent update(...): Measures the motion energy of the frame against the previous one and advances the state machine.
+    - void finish(...): Closes the shot still in progress at the end of the clip.
+    - void print_timeline(): Prints the shots found so far.
+    - bool save_timeline(...): Writes the shots found so far to a text file.
+*/
+
+#include "shotSegmenter.h"
+
+#include <fstream>
+
+shotSegmenter::shotSegmenter(){
+    this->scale = 1.0;
+    this->moving = false;
+    this->quiet_frames = 0;
+    this->start_frame = 0;
+    this->peak_energy = 0;
+
+    this->pixel_threshold = 25;
+    this->start_threshold = 10;
+    this->rest_threshold = 3;
+    this->rest_frames = 8;
+
+    this->energy = 0;
+}
+
+void shotSegmenter::set_table(const cv::Mat& seg_mask){
+    this->table_rect = cv::boundingRect(seg_mask);
+    this->previous.release();
+    if (this->table_rect.empty())
+        return;
+
+    this->scale = std::min(1.0, static_cast<double>(WIDTH) / this->table_rect.width);
+    cv::Size small_size(cvRound(this->table_rect.width * this->scale), cvRound(this->table_rect.height * this->scale));
+    cv::resize(seg_mask(this->table_rect), this->table_mask, small_size, 0, 0, cv::INTER_NEAREST);
+}
+
+shotEvent shotSegmenter::update(const cv::Mat& frame, int frame_index){
+    if (this->table_rect.empty())
+        return SHOT_NONE;
+
+    // Small grayscale view of the table
+    cv::resize(frame(this->table_rect), this->small_bgr, this->table_mask.size(), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(this->small_bgr, this->current, cv::COLOR_BGR2GRAY);
+    if (this->previous.empty()) {
+        std::swap(this->previous, this->current);
+        return SHOT_NONE;
+    }
+
+    // Motion energy: table pixels that changed since the previous frame
+    cv::absdiff(this->current, this->previous, this->diff);
+    cv::threshold(this->diff, this->diff, this->pixel_threshold, 255, cv::THRESH_BINARY);
+    cv::bitwise_and(this->diff, this->table_mask, this->diff);
+    this->energy = cv::countNonZero(this->diff);
+    std::swap(this->previous, this->current);
+
+    if (!this->moving) {
+        if (this->energy > this->start_threshold) {
+            this->moving = true;
+            this->start_frame = frame_index;
+            this->peak_energy = this->energy;
+            this->quiet_frames = 0;
+            return SHOT_START;
+        }
+        return SHOT_NONE;
+    }
+
+    this->peak_energy = std::max(this->peak_energy, this->energy);
+    if (this->energy < this->rest_threshold)
+        this->quiet_frames++;
+    else
+        this->quiet_frames = 0;
+
+    // Balls at rest: the shot is over
+    if (this->quiet_frames >= this->rest_frames) {
+        this->moving = false;
+        shotRecord shot;
+        shot.start_frame = this->start_frame;
+        shot.end_frame = frame_index - this->rest_frames + 1;
+        shot.peak_energy = this->peak_energy;
+        this->shots.push_back(shot);
+        return SHOT_END;
+    }
+    return SHOT_NONE;
+}
+
+void shotSegmenter::finish(int last_frame){
+    if (!this->moving)
+        return;
+
+    this->moving = false;
+    shotRecord shot;
+    shot.start_frame = this->start_frame;
+    shot.end_frame = last_frame;
+    shot.peak_energy = this->peak_energy;
+    this->shots.push_back(shot);
+}
+
+void shotSegmenter::print_timeline() const{
+    std::cout << "---SHOTS---------------" << std::endl;
+    if (this->shots.empty())
+        std::cout << "No shot found." << std::endl;
+    for (size_t s = 0; s < this->shots.size(); ++s) {
+        std::cout << "Shot " << s+1 << ": frames " << this->shots[s].start_frame << " - " << this->shots[s].end_frame
+                  << " (peak energy " << this->shots[s].peak_energy << ")" << std::endl;
+    }
+}
+
+bool shotSegmenter::save_timeline(const std::string& path) const{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << "." << std::endl;
+        return false;
+    }
+
+    file << "# shot start_frame end_frame peak_energy" << std::endl;
+    for (size_t s = 0; s < this->shots.size(); ++s) {
+        file << s+1 << " " << this->shots[s].start_frame << " " << this->shots[s].end_frame << " " << this->shots[s].peak_energy << std::endl;
+    }
+    return true;
+}
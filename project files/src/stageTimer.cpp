@@ -0,0 +1,198 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: stageTimer.cpp
+    DESCRIPTION: Implements the per-thread stage histograms and the percentile report.
+
+    FUNCTIONS:
+    - int bucket_index(...) / double bucket_value(...): Log-linear bucket of a duration, and the middle of a bucket.
+    - double percentile(...): Value of the given percentile of one stage, from the merged counts.
+    - const char* stage_name(...): Name of a stage, as printed and written.
+
+    METHODS:
+    - stageProfiler(): Constructor, without histograms (they are created by the threads that record).
+    - stageHistogram& local(): Histogram of the calling thread, created on its first record.
+    - void record(...): Adds a duration (ns) to the histogram of the calling thread.
+    - stageSummary summary(...): Merges the histograms of all the threads for one stage.
+    - void print_report(): Prints p50/p90/p99/max of every stage that recorded something.
+    - bool save_json(...): Writes the same report to a JSON file.
+*/
+
+#include "stageTimer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static std::atomic<int> next_profiler_id(0);
+
+// Histogram of the calling thread for the last profiler it recorded for
+struct localHistogram{
+
+    int owner;
+    stageHistogram* histogram;
+
+};
+
+static thread_local localHistogram local_histogram = {-1, nullptr};
+
+
+static int bucket_index(uint64_t ns){
+    if (ns < static_cast<uint64_t>(stageHistogram::SUB_BUCKETS))
+        return static_cast<int>(ns);
+
+    // ns = x * 2^e with x in [SUB_BUCKETS, 2*SUB_BUCKETS)
+    int e = 0;
+    while (ns >= 2 * static_cast<uint64_t>(stageHistogram::SUB_BUCKETS)) {
+        ns >>= 1;
+        ++e;
+    }
+    return (e + 1) * stageHistogram::SUB_BUCKETS + static_cast<int>(ns) - stageHistogram::SUB_BUCKETS;
+}
+
+static double bucket_value(int index){
+    if (index < stageHistogram::SUB_BUCKETS)
+        return index;
+
+    int e = index / stageHistogram::SUB_BUCKETS - 1;
+    double width = static_cast<double>(uint64_t(1) << e);
+    double low = (stageHistogram::SUB_BUCKETS + index % stageHistogram::SUB_BUCKETS) * width;
+    return low + width / 2.0;
+}
+
+static double percentile(const std::vector<uint64_t>& counts, uint64_t samples, double p, uint64_t max_ns){
+    uint64_t rank = static_cast<uint64_t>(p * samples + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+        seen += counts[b];
+        if (seen >= rank)
+            return std::min(bucket_value(static_cast<int>(b)), static_cast<double>(max_ns));
+    }
+    return static_cast<double>(max_ns);
+}
+
+const char* stage_name(timedStage stage){
+    switch (stage) {
+        case STAGE_DECODE: return "decode";
+        case STAGE_GRAB: return "grab";
+        case STAGE_DETECT_TABLE: return "detect_table";
+        case STAGE_DETECT_BALLS: return "detect_balls";
+        case STAGE_INIT_TRACKERS: return "initializeTrackers";
+        case STAGE_UPDATE_TRACKERS: return "updateTrackers";
+        case STAGE_DRAW_FRAME: return "draw_frame";
+        case STAGE_PROJECT: return "project";
+        case STAGE_ENCODE: return "encode";
+        default: return "unknown";
+    }
+}
+
+
+stageProfiler::stageProfiler(){
+    this->id = next_profiler_id++;
+}
+
+stageHistogram& stageProfiler::local(){
+    if (local_histogram.owner == this->id)
+        return *local_histogram.histogram;
+
+    // First record of this thread (or back from another profiler): find or create its histogram
+    std::lock_guard<std::mutex> lock(this->registry_mutex);
+    std::thread::id self = std::this_thread::get_id();
+    stageHistogram* histogram = nullptr;
+    for (size_t t = 0; t < this->owners.size(); ++t) {
+        if (this->owners[t] == self)
+            histogram = this->histograms[t].get();
+    }
+    if (histogram == nullptr) {
+        this->histograms.push_back(std::unique_ptr<stageHistogram>(new stageHistogram()));
+        this->owners.push_back(self);
+        histogram = this->histograms.back().get();
+    }
+    local_histogram.owner = this->id;
+    local_histogram.histogram = histogram;
+    return *histogram;
+}
+
+void stageProfiler::record(timedStage stage, int64_t ns){
+    stageHistogram& histogram = this->local();
+    uint64_t value = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    histogram.counts[stage][bucket_index(value)]++;
+    histogram.samples[stage]++;
+    histogram.total_ns[stage] += value;
+    if (value > histogram.max_ns[stage])
+        histogram.max_ns[stage] = value;
+}
+
+stageSummary stageProfiler::summary(timedStage stage) const{
+    std::vector<uint64_t> counts(stageHistogram::BUCKETS, 0);
+    uint64_t samples = 0, total = 0, max_ns = 0;
+    for (const std::unique_ptr<stageHistogram>& histogram : this->histograms) {
+        for (int b = 0; b < stageHistogram::BUCKETS; ++b)
+            counts[b] += histogram->counts[stage][b];
+        samples += histogram->samples[stage];
+        total += histogram->total_ns[stage];
+        max_ns = std::max(max_ns, histogram->max_ns[stage]);
+    }
+
+    stageSummary result = {0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (samples == 0)
+        return result;
+    result.count = static_cast<long long>(samples);
+    result.mean_ms = total / 1e6 / samples;
+    result.p50_ms = percentile(counts, samples, 0.50, max_ns) / 1e6;
+    result.p90_ms = percentile(counts, samples, 0.90, max_ns) / 1e6;
+    result.p99_ms = percentile(counts, samples, 0.99, max_ns) / 1e6;
+    result.max_ms = max_ns / 1e6;
+    return result;
+}
+
+void stageProfiler::print_report() const{
+#ifndef STAGE_TIMERS
+    std::cout << "Stage timers: disabled at compile time (STAGE_TIMERS)" << std::endl;
+#else
+    std::cout << "---STAGE TIMINGS (ms)--" << std::endl;
+    std::cout << std::left << std::setw(20) << "stage" << std::right << std::setw(8) << "count" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        stageSummary stats = this->summary(static_cast<timedStage>(s));
+        if (stats.count == 0)
+            continue;
+        std::cout << std::left << std::setw(20) << stage_name(static_cast<timedStage>(s)) << std::right << std::setw(8) << stats.count
+                  << std::setw(10) << stats.p50_ms << std::setw(10) << stats.p90_ms << std::setw(10) << stats.p99_ms << std::setw(10) << stats.max_ms << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+#endif
+}
+
+bool stageProfiler::save_json(const std::string& path) const{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << "." << std::endl;
+        return false;
+    }
+
+#ifdef STAGE_TIMERS
+    file << "{" << std::endl << "  \"enabled\": true," << std::endl << "  \"stages\": {";
+#else
+    file << "{" << std::endl << "  \"enabled\": false," << std::endl << "  \"stages\": {";
+#endif
+    file << std::fixed << std::setprecision(4);
+    bool first = true;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        stageSummary stats = this->summary(static_cast<timedStage>(s));
+        if (stats.count == 0)
+            continue;
+        file << (first ? "" : ",") << std::endl;
+        file << "    \"" << stage_name(static_cast<timedStage>(s)) << "\": {\"count\": " << stats.count << ", \"mean_ms\": " << stats.mean_ms
+             << ", \"p50_ms\": " << stats.p50_ms << ", \"p90_ms\": " << stats.p90_ms << ", \"p99_ms\": " << stats.p99_ms << ", \"max_ms\": " << stats.max_ms << "}";
+        first = false;
+    }
+    file << std::endl << "  }" << std::endl << "}" << std::endl;
+    return true;
+}
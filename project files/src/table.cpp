@@ -8,32 +8,45 @@
 
     METHODS:
     - tableDetector::tableDetector(): Default constructor for initializing the `tableDetector` object.
-    - cv::Scalar get_dominant_color(): Calculates the dominant color in the image by analyzing the hue channel in HSV color space. The dominant color is returned with mid-range saturation and brightness.
+    - cv::Scalar get_dominant_color(...): Calculates the dominant color in the image by analyzing the hue channel in HSV color space. The dominant color is returned with mid-range saturation and brightness.
     - cv::Mat treshold_mask(...): Creates a binary mask of the image where the pixels fall within the specified color range. Applies Gaussian blur to smooth the image before thresholding.
     - cv::Mat find_largest_comp(...): Identifies the largest connected component in the binary mask. Performs morphological closing to remove small holes and noise.
     - std::vector<cv::Point> find_contour(...): Finds the contour of the largest connected component. Uses `findContours` to extract the contour points.
     - std::vector<cv::Point> get_hull(...): Computes the convex hull of the contour.
-    - void find_table(...): Main method for detecting the table. It calculates the dominant color, thresholds the image, finds the largest component, determines the table color, detects contours, computes the convex hull, and finds table corners.
-    - cv::Mat draw_borders(...): Draws the detected table borders and corners on the image for visualization.
+    - void find_table(...): Main method for detecting the table, on the frame of the given context (the HSV conversion is shared through it).
+    - void segment_default(...): Default segmentation path: dominant color, blurred thresholding, largest component and its mean color.
+    - void finish_table(...): Contour, segmentation mask and hull of the table from the mask of the largest component (shared by both paths).
+    - void segment_fused(...): Fused segmentation path: hue histogram on a subsampled grid, hue-range mask in a single pass over the HSV image, largest component mask and its mean color in a single pass over the labels. Used by `find_table` when `fused` is set.
+    - cv::Mat draw_borders(...): Draws the detected table borders and corners on the image for visualization. A static overload draws given borders and corners into a reusable output image.
     - cv::Point2f get_intersection_point(...): Computes the intersection point of two lines defined by their endpoints. Handles cases where lines are parallel.
-    - std::vector<cv::Point2f> tableDetector::find_corners(): Detects and returns corners of the table by finding intersections of detected lines. 
+    - std::vector<cv::Point2f> tableDetector::find_corners(...): Detects and returns corners of the table by finding intersections of detected lines. The pixel parameters are multiplied by the given scale, so it can also run on a downscaled frame.
+    - void find_table_pyramid(...): Pyramid mode of `find_table`: segmentation and corners on the frame downscaled by 2^`pyramid_levels`, then the boundary is refined at full resolution in the tiles it crosses and the corners by line fits on the full resolution contour.
+    - void refine_mask(...): Upscales the coarse mask and thresholds again at full resolution only the tiles along its boundary.
+    - std::vector<cv::Point2f> refine_corners(...): Fits a line on the full resolution contour points near each side of the coarse quadrilateral and intersects consecutive sides.
+    - std::vector<cv::Point2f> find_quad_corners(): Corners from the hull geometry alone: quadrilateral approximation of the hull (smallest enclosing rectangle if none), then a line fit on the contour points along each side. Used instead of `find_corners` when `quad_corners` is set.
 
     NOTES:
     - The color thresholding is manually tuned for the table's expected color in the HSV color space.
     - The `find_corners` method uses the Hough Line Transform to detect lines and their intersections, which are then used to identify table corners.
+    - `find_quad_corners` always returns 4 corners sorted clockwise and does not touch the image: its cost depends only on the number of contour points. The Hough path can return any number of corners.
+    - In pyramid mode only the tiles along the boundary of the table are converted and thresholded at full resolution, and the Hough transform of `find_corners` runs on the small frame: the cost depends little on the input resolution.
+    - The fused path skips the Gaussian blur of the HSV image (the closing removes the isolated pixels it would have smoothed) and reads one pixel every `SAMPLE_STEP` in both directions for the histogram. Its mask matches the one of the default path up to a few pixels along the borders (see the table benchmark in `benchmark.h`).
 */
 
 #include "table.h"
+#include "tableCalibration.h"
 
 tableDetector::tableDetector(){
+    this->fused = false;
+    this->pyramid_levels = 0;
+    this->quad_corners = false;
 }
 
 
-cv::Scalar tableDetector::get_dominant_color() {
+cv::Scalar tableDetector::get_dominant_color(frameContext& context) {
 
-    // Translate the image in HSV color scale
-    cv::Mat hsv_img;
-    cv::cvtColor(this->origin_frame, hsv_img, cv::COLOR_BGR2HSV);
+    // The image in HSV color scale (shared with the other stages)
+    cv::Mat hsv_img = context.hsv();
 
     int h_bins = 64;
     int bins[] = {h_bins};
@@ -53,19 +66,18 @@ cv::Scalar tableDetector::get_dominant_color() {
 }
 
 
-cv::Mat tableDetector::treshold_mask(const cv::Scalar& color) {
+cv::Mat tableDetector::treshold_mask(frameContext& context, const cv::Scalar& color) {
 
-    // Translate the image in HSV color scale and apply a gaussian smoothing
-    cv::Mat hsv_img, mask;
-    cv::cvtColor(this->origin_frame, hsv_img, cv::COLOR_BGR2HSV);
-    cv::GaussianBlur(hsv_img, hsv_img, cv::Size(5, 5), 0, 0);
+    // Apply a gaussian smoothing to the HSV image (shared, so blurred into our own buffer)
+    cv::Mat mask;
+    cv::GaussianBlur(context.hsv(), this->blurred_hsv, cv::Size(5, 5), 0, 0);
 
     // Define the accepted ranges (handtuned)
     cv::Scalar lower_bound(color[0] - 10, 100, 60);
     cv::Scalar upper_bound(color[0] + 10, 250, 250);
 
     // Apply treshold
-    cv::inRange(hsv_img, lower_bound, upper_bound, mask);
+    cv::inRange(this->blurred_hsv, lower_bound, upper_bound, mask);
 
     return mask;
 }
@@ -120,38 +132,324 @@ std::vector<cv::Point> tableDetector::get_hull(const std::vector<cv::Point>& con
 }
 
 
-void tableDetector::find_table(const cv::Mat& img){
+void tableDetector::find_table(frameContext& context){
 
-    this->origin_frame = img.clone();
-    cv::Scalar table_color = this->get_dominant_color();
+    if (this->pyramid_levels > 0) {
+        this->find_table_pyramid(context);
+        return;
+    }
+
+    this->origin_frame = context.bgr().clone();
+
+    cv::Mat mask;
+    if (this->fused)
+        this->segment_fused(context, mask);
+    else
+        this->segment_default(context, mask);
+
+    this->finish_table(mask);
+    this->corners = this->quad_corners ? this->find_quad_corners() : this->find_corners();
+}
+
+
+void tableDetector::segment_default(frameContext& context, cv::Mat& mask){
+
+    cv::Scalar table_color = this->get_dominant_color(context);
     this->hue_color = table_color[0];
-    cv::Mat tresholded_img = this->treshold_mask(table_color);
-    cv::Mat mask = this->find_largest_comp(tresholded_img);
+    cv::Mat tresholded_img = this->treshold_mask(context, table_color);
+    mask = this->find_largest_comp(tresholded_img);
 
     // Find table bgr_color
     cv::Mat masked;
     this->origin_frame.copyTo(masked,mask);
     this->bgr_color = cv::mean(masked);
+}
+
+
+void tableDetector::find_table_pyramid(frameContext& context){
+
+    const cv::Mat& frame = context.bgr();
+    int factor = 1 << this->pyramid_levels;
+
+    // Coarse detection on the small frame (the segmentation steps read origin_frame)
+    cv::Size small_size(std::max(1, frame.cols / factor), std::max(1, frame.rows / factor));
+    cv::resize(frame, this->small_frame, small_size, 0, 0, cv::INTER_AREA);
+    this->small_context.reset(this->small_frame);
+    this->origin_frame = this->small_frame;
+
+    cv::Mat small_mask;
+    if (this->fused)
+        this->segment_fused(this->small_context, small_mask);
+    else
+        this->segment_default(this->small_context, small_mask);
+
+    this->finish_table(small_mask);
+    std::vector<cv::Point2f> coarse_corners = this->quad_corners ? this->find_quad_corners() : this->find_corners(1.0 / factor);
+    for (cv::Point2f& corner : coarse_corners)
+        corner *= static_cast<float>(factor);
+
+    // Refinement at full resolution, only along the borders
+    this->origin_frame = frame.clone();
+    cv::Mat mask;
+    this->refine_mask(frame, small_mask, factor, mask);
+
+    // The tiles thresholded again can leave specks near the border: keep the table only
+    mask = this->find_largest_comp(mask);
+    this->finish_table(mask);
+    this->corners = this->refine_corners(coarse_corners, mask, factor);
+}
+
+
+void tableDetector::refine_mask(const cv::Mat& frame, const cv::Mat& small_mask, int factor, cv::Mat& mask){
+
+    // Nearest upscaling: exact inside and outside of the table, blocky along the border
+    cv::resize(small_mask, mask, frame.size(), 0, 0, cv::INTER_NEAREST);
+
+    // Same bounds as treshold_mask
+    cv::Scalar lower_bound(this->hue_color - 10, 100, 60);
+    cv::Scalar upper_bound(this->hue_color + 10, 250, 250);
+    cv::Mat dilate_kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2*factor + 1, 2*factor + 1));
+    cv::Mat close_kernel = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(3, 3));
+    cv::Rect small_rect(0, 0, small_mask.cols, small_mask.rows);
+    cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+
+    for (int by = 0; by < small_mask.rows; by += REFINE_BLOCK) {
+        for (int bx = 0; bx < small_mask.cols; bx += REFINE_BLOCK) {
+
+            // The border crosses the block (or passes next to it, hence the 1 px margin)
+            cv::Rect block(bx, by, REFINE_BLOCK, REFINE_BLOCK);
+            cv::Rect neighbourhood = cv::Rect(bx - 1, by - 1, REFINE_BLOCK + 2, REFINE_BLOCK + 2) & small_rect;
+            int inside = cv::countNonZero(small_mask(neighbourhood));
+            if (inside == 0 || inside == neighbourhood.area())
+                continue;
+
+            // Threshold again at full resolution, accepting only pixels near the coarse table
+            cv::Rect tile = cv::Rect(block.x * factor, block.y * factor, block.width * factor, block.height * factor) & frame_rect;
+            if (tile.empty())
+                continue;
+            cv::cvtColor(frame(tile), this->tile_hsv, cv::COLOR_BGR2HSV);
+            cv::inRange(this->tile_hsv, lower_bound, upper_bound, this->tile_thresh);
+            cv::dilate(mask(tile), this->tile_allowed, dilate_kernel);
+            cv::bitwise_and(this->tile_thresh, this->tile_allowed, this->tile_thresh);
+            cv::morphologyEx(this->tile_thresh, this->tile_thresh, cv::MORPH_CLOSE, close_kernel);
+            this->tile_thresh.copyTo(mask(tile));
+        }
+    }
+}
+
+
+// Intersection of two lines given as (vx, vy, x0, y0)
+static bool intersect_lines(const cv::Vec4f& l1, const cv::Vec4f& l2, cv::Point2f& point){
+    float denom = l1[0] * l2[1] - l1[1] * l2[0];
+    if (std::abs(denom) < 1e-6f)
+        return false;
+    float t = ((l2[2] - l1[2]) * l2[1] - (l2[3] - l1[3]) * l2[0]) / denom;
+    point = cv::Point2f(l1[2] + t * l1[0], l1[3] + t * l1[1]);
+    return true;
+}
+
+
+// Fits a line on the border points close to each side of the (clockwise) quad, away from the corners and their pockets,
+// and intersects consecutive sides. A side with too few points keeps its original line, a corner that moves more than max_shift is kept.
+static std::vector<cv::Point2f> fit_quad_sides(const std::vector<cv::Point2f>& quad, const std::vector<cv::Point>& border, double band, double max_shift){
+
+    std::vector<cv::Vec4f> sides(4);
+    for (int k = 0; k < 4; ++k) {
+        cv::Point2f a = quad[k], b = quad[(k + 1) % 4];
+        cv::Point2f dir = b - a;
+        double length = cv::norm(dir);
+        sides[k] = cv::Vec4f(dir.x / length, dir.y / length, a.x, a.y);
+        if (length < 1.0)
+            continue;
+
+        std::vector<cv::Point2f> points;
+        for (const cv::Point& p : border) {
+            cv::Point2f ap = cv::Point2f(p) - a;
+            double along = (ap.x * dir.x + ap.y * dir.y) / (length * length);
+            double across = std::abs(ap.x * dir.y - ap.y * dir.x) / length;
+            if (along > 0.1 && along < 0.9 && across < band)
+                points.push_back(cv::Point2f(p));
+        }
+        if (points.size() >= 10)
+            cv::fitLine(points, sides[k], cv::DIST_HUBER, 0, 0.01, 0.01);
+    }
+
+    // Corners = intersections of consecutive sides
+    std::vector<cv::Point2f> refined(4);
+    for (int k = 0; k < 4; ++k) {
+        if (!intersect_lines(sides[(k + 3) % 4], sides[k], refined[k]) || cv::norm(refined[k] - quad[k]) > max_shift)
+            refined[k] = quad[k];
+    }
+    return refined;
+}
+
+
+std::vector<cv::Point2f> tableDetector::refine_corners(const std::vector<cv::Point2f>& coarse, const cv::Mat& mask, int factor){
+
+    if (coarse.size() != 4)
+        return coarse;
+
+    std::vector<cv::Point2f> quad = coarse;
+    sortCornersClockwise(quad);
+
+    // Dense outer border of the refined mask
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+    if (contours.empty())
+        return quad;
+    size_t largest = 0;
+    for (size_t c = 1; c < contours.size(); ++c) {
+        if (contours[c].size() > contours[largest].size())
+            largest = c;
+    }
+
+    double band = 2.0 * factor;
+    return fit_quad_sides(quad, contours[largest], band, 2.0 * band);
+}
+
+
+std::vector<cv::Point2f> tableDetector::find_quad_corners(){
+
+    std::vector<cv::Point2f> quad;
+    if (this->hull.empty())
+        return quad;
+
+    // Quadrilateral approximation of the hull: bisection on the tolerance until exactly 4 vertices remain
+    double perimeter = cv::arcLength(this->hull, true);
+    double low = 0.0, high = 0.25 * perimeter;
+    std::vector<cv::Point> approx;
+    for (int it = 0; it < 30; ++it) {
+        double epsilon = 0.5 * (low + high);
+        cv::approxPolyDP(this->hull, approx, epsilon, true);
+        if (approx.size() == 4)
+            break;
+        if (approx.size() > 4)
+            low = epsilon;
+        else
+            high = epsilon;
+    }
+
+    if (approx.size() == 4) {
+        for (const cv::Point& p : approx)
+            quad.push_back(cv::Point2f(p));
+    } else {
+        // No tolerance gives 4 vertices (e.g. almost triangular hull): smallest enclosing rectangle
+        cv::Point2f box[4];
+        cv::minAreaRect(this->hull).points(box);
+        quad.assign(box, box + 4);
+    }
+    sortCornersClockwise(quad);
+
+    // The hull cuts the corners of the cloth (pockets, occlusions): refine every side on the points of the contour.
+    // The contour stores only the ends of its straight runs, so it is resampled every pixel first.
+    std::vector<cv::Point> border;
+    border.reserve(static_cast<size_t>(cv::arcLength(this->contour, true)) + this->contour.size());
+    for (size_t i = 0; i < this->contour.size(); ++i) {
+        cv::Point a = this->contour[i], b = this->contour[(i + 1) % this->contour.size()];
+        int steps = std::max(std::abs(b.x - a.x), std::abs(b.y - a.y));
+        for (int s = 0; s < std::max(1, steps); ++s)
+            border.push_back(a + (b - a) * s / std::max(1, steps));
+    }
+
+    double band = std::max(3.0, 0.005 * perimeter);
+    return fit_quad_sides(quad, border, band, 4.0 * band);
+}
+
+
+void tableDetector::segment_fused(frameContext& context, cv::Mat& mask){
+
+    cv::Mat hsv_img = context.hsv();
+    const int h_bins = 64;
+
+    // Hue histogram on a subsampled grid
+    int hist[h_bins] = {0};
+    for (int y = SAMPLE_STEP / 2; y < hsv_img.rows; y += SAMPLE_STEP) {
+        const uchar* row = hsv_img.ptr<uchar>(y);
+        for (int x = SAMPLE_STEP / 2; x < hsv_img.cols; x += SAMPLE_STEP)
+            hist[row[3*x] * h_bins / 180]++;
+    }
+    int max_val_idx = 0;
+    for (int b = 1; b < h_bins; ++b) {
+        if (hist[b] > hist[max_val_idx])
+            max_val_idx = b;
+    }
+    this->hue_color = (max_val_idx * 180.0) / h_bins;
+
+    // Hue-range mask in one pass (same bounds as treshold_mask: inRange rounds the Scalar bounds to the nearest integer)
+    int h_low = cvRound(this->hue_color - 10), h_high = cvRound(this->hue_color + 10);
+    mask.create(hsv_img.size(), CV_8UC1);
+    for (int y = 0; y < hsv_img.rows; ++y) {
+        const uchar* hsv = hsv_img.ptr<uchar>(y);
+        uchar* out = mask.ptr<uchar>(y);
+        for (int x = 0; x < hsv_img.cols; ++x, hsv += 3) {
+            bool in = hsv[0] >= h_low && hsv[0] <= h_high && hsv[1] >= 100 && hsv[1] <= 250 && hsv[2] >= 60 && hsv[2] <= 250;
+            out[x] = in ? 255 : 0;
+        }
+    }
+
+    // Closing (pre-processing) and components
+    cv::Mat element = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(3, 3));
+    cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, element);
+    int num = cv::connectedComponentsWithStats(mask, this->labels, this->stats, this->centroids);
+
+    int curr_largest = 1;
+    for (int i = 2; i < num; i++) {
+        if (this->stats.at<int>(i, cv::CC_STAT_AREA) > this->stats.at<int>(curr_largest, cv::CC_STAT_AREA))
+            curr_largest = i;
+    }
+
+    // Mask of the largest component and sum of its colors in one pass over the labels
+    double sum_b = 0, sum_g = 0, sum_r = 0;
+    for (int y = 0; y < mask.rows; ++y) {
+        const int* label = this->labels.ptr<int>(y);
+        const uchar* bgr = this->origin_frame.ptr<uchar>(y);
+        uchar* out = mask.ptr<uchar>(y);
+        for (int x = 0; x < mask.cols; ++x, bgr += 3) {
+            if (label[x] == curr_largest) {
+                out[x] = 255;
+                sum_b += bgr[0];
+                sum_g += bgr[1];
+                sum_r += bgr[2];
+            } else {
+                out[x] = 0;
+            }
+        }
+    }
+
+    // Same value as the default path: mean over the whole frame of the masked copy
+    double total = static_cast<double>(mask.total());
+    this->bgr_color = cv::Scalar(sum_b / total, sum_g / total, sum_r / total);
+}
+
+
+void tableDetector::finish_table(const cv::Mat& mask){
 
     this->contour = this->find_contour(mask);
     this->seg_mask = cv::Mat::zeros(this->origin_frame.size(), CV_8UC1);
     cv::fillPoly(this->seg_mask, this->contour, cv::Scalar(255));
 
     this->hull = get_hull(this->contour);
-    this->corners = this->find_corners();
 
 }
 
 
 cv::Mat tableDetector::draw_borders(const cv::Mat& img){
 
-    cv::Mat edited = img.clone();
-    //cv::polylines(edited, this->contour, true, cv::Scalar(0, 255, 255), 1); 
-    cv::polylines(edited, this->hull, true, cv::Scalar(0, 255, 255), 2);
+    cv::Mat edited;
+    draw_borders(img, edited, this->hull, this->corners);
+    return edited;
+
+}
+
+
+void tableDetector::draw_borders(const cv::Mat& img, cv::Mat& edited, const std::vector<cv::Point>& hull, const std::vector<cv::Point2f>& corners){
+
+    img.copyTo(edited);
+    //cv::polylines(edited, contour, true, cv::Scalar(0, 255, 255), 1); 
+    cv::polylines(edited, hull, true, cv::Scalar(0, 255, 255), 2);
 
-    for (const cv::Point2f& point : this->corners)
+    for (const cv::Point2f& point : corners)
         cv::circle(edited, point, 3, cv::Scalar(0, 0, 255), cv::FILLED);
-    return edited;
 
 }
 
@@ -174,18 +472,21 @@ cv::Point2f tableDetector::get_intersection_point(const cv::Vec4i& line1, const
     return cv::Point2f(px, py);
 }
 
-std::vector<cv::Point2f> tableDetector::find_corners(){
+std::vector<cv::Point2f> tableDetector::find_corners(double scale){
 
     cv::Mat ROI = cv::Mat::zeros(this->origin_frame.size(), CV_8UC1);
     cv::fillConvexPoly(ROI, this->hull, cv::Scalar(255));
 
+    // Pixel parameters scaled with the frame (scale = 1 at full resolution)
+    int kernel = std::max(3, cvRound(25 * scale) | 1);
+
     cv::Mat blurred_ROI;
-    cv::GaussianBlur(ROI, blurred_ROI, cv::Size(25, 25), 0);
+    cv::GaussianBlur(ROI, blurred_ROI, cv::Size(kernel, kernel), 0);
     cv::Mat canny;
     cv::Canny(blurred_ROI, canny, 20, 50);
 
     std::vector<cv::Vec4i> lines;
-    cv::HoughLinesP(canny, lines, 2, 3*CV_PI/180, 80, 200, 1000);
+    cv::HoughLinesP(canny, lines, std::max(1.0, 2 * scale), 3*CV_PI/180, std::max(10, cvRound(80 * scale)), 200 * scale, 1000 * scale);
 
     /* --Debug
     cv::Mat output;
@@ -197,7 +498,7 @@ std::vector<cv::Point2f> tableDetector::find_corners(){
 
     // Find and highlight intersections
     std::vector<cv::Point2f> intersection_points;
-    double tresh_distance = 20.0;
+    double tresh_distance = 20.0 * scale;
 
     for (int i = 0; i < lines.size(); i++) {
         for (int j = i + 1; j < lines.size(); j++) {
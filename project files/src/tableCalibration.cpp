@@ -0,0 +1,136 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: tableCalibration.cpp
+    DESCRIPTION: Contains the implementation of the `tableCalibration` class, which caches the table geometry (mask, borders, corners, homography and orientation) and invalidates it only when the camera moves.
+
+    CLASS: tableCalibration
+
+    METHODS:
+    - tableCalibration::tableCalibration(): Default constructor, the calibration starts invalid.
+    - void calibrate(...): Stores the result of a `tableDetector` run (mask, borders, corners), computes the homography towards the minimap and the table orientation, and takes the current frame as reference view.
+    - bool camera_moved(...): Cheap check of the camera motion against the reference view, using phase correlation on a small grayscale version of the frame.
+    - void make_reference(...): Downscales and converts a frame to the floating point grayscale image used by the motion check.
+
+    FUNCTIONS:
+    - cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points): Computes the centroid of a given set of points.
+    - std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners): Sorts corners in clockwise order based on their angle from the centroid.
+
+    NOTES:
+    - Phase correlation measures the global translation between the reference and the current view. Moving balls and players barely affect it, while any pan of the camera shows up as a shift or as a low correlation peak.
+*/
+
+#include "tableCalibration.h"
+
+cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points) {
+    cv::Point2f centroid(0, 0);
+    for (const auto& pt : points) {
+        centroid += pt;
+    }
+    centroid *= (1.0 / points.size());
+    return centroid;
+}
+
+std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners) {
+    // Calculate centroid
+    cv::Point2f centroid = computeCentroid(corners);
+
+    // Sort corners based on the angle they make with the centroid
+    std::sort(corners.begin(), corners.end(), [centroid](const cv::Point2f& a, const cv::Point2f& b) {
+        return std::atan2(a.y - centroid.y, a.x - centroid.x) < std::atan2(b.y - centroid.y, b.x - centroid.x);
+    });
+
+    return corners;
+}
+
+
+tableCalibration::tableCalibration(){
+    this->reference_width = 256;
+    this->max_shift = 3.0;
+    this->min_response = 0.1;
+    this->scale = 1.0;
+    this->valid = false;
+    this->id = 0;
+    this->isVertical = false;
+}
+
+
+void tableCalibration::make_reference(const cv::Mat& frame, cv::Mat& out){
+
+    // Downscale first, so that the conversions run on few pixels
+    this->scale = static_cast<double>(this->reference_width) / frame.cols;
+    cv::Size small_size(this->reference_width, std::max(1, cvRound(frame.rows * this->scale)));
+    cv::resize(frame, this->small_bgr, small_size, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(this->small_bgr, this->small_gray, cv::COLOR_BGR2GRAY);
+    this->small_gray.convertTo(out, CV_32F);
+}
+
+
+void tableCalibration::calibrate(const cv::Mat& frame, const tableDetector& table, const std::vector<cv::Point2f>& dstCorners){
+
+    this->seg_mask = table.seg_mask;
+    this->contour = table.contour;
+    this->hull = table.hull;
+    this->corners = table.corners;
+
+    // Compute the homography towards the minimap
+    this->homography = cv::Mat();
+    this->isVertical = false;
+    if (this->corners.size() == 4) {
+
+        // Ensure corners are sorted clockwise
+        std::vector<cv::Point2f> sortedCorners = this->corners;
+        sortedCorners = sortCornersClockwise(sortedCorners);
+
+        // Compute perspective transform matrix
+        cv::Mat perspectiveMatrix = cv::getPerspectiveTransform(sortedCorners, dstCorners);
+
+        // Transform reference points to get original frame coordinates
+        std::vector<cv::Point2f> transformedCorners(4);
+        cv::perspectiveTransform(dstCorners, transformedCorners, perspectiveMatrix);
+
+        // Compute diagonal lengths of the transformed rectangle
+        double diagonal1Length = cv::norm(transformedCorners[2] - transformedCorners[0]); // Top-left to bottom-right
+        double diagonal2Length = cv::norm(transformedCorners[3] - transformedCorners[1]); // Top-right to bottom-left
+
+        // Determine table orientation
+        this->isVertical = (diagonal1Length > diagonal2Length);
+
+        // Adjust perspective matrix for vertical table
+        if (this->isVertical) {
+            std::rotate(sortedCorners.begin(), sortedCorners.begin() + 1, sortedCorners.end());
+            perspectiveMatrix = cv::getPerspectiveTransform(sortedCorners, dstCorners);
+        }
+        this->homography = perspectiveMatrix;
+    }
+    else {
+        std::cerr << "Warning: " << this->corners.size() << " table corners found, 4 are needed for the minimap." << std::endl;
+    }
+
+    // The current view becomes the reference for the motion check
+    this->make_reference(frame, this->reference);
+    cv::createHanningWindow(this->window, this->reference.size(), CV_32F);
+
+    this->valid = true;
+    this->id++;
+}
+
+
+bool tableCalibration::camera_moved(const cv::Mat& frame){
+
+    if (!this->valid || this->reference.empty())
+        return true;
+
+    this->make_reference(frame, this->small_float);
+    if (this->small_float.size() != this->reference.size())
+        return true;    // resolution changed
+
+    double response = 0.0;
+    cv::Point2d shift = cv::phaseCorrelate(this->reference, this->small_float, this->window, &response);
+
+    // Shift back to full resolution pixels
+    double shift_px = std::sqrt(shift.x * shift.x + shift.y * shift.y) / this->scale;
+
+    //--Debug  std::cout << "camera shift: " << shift_px << " px, response: " << response << std::endl;
+    return shift_px > this->max_shift || response < this->min_response;
+}
@@ -0,0 +1,85 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: trackClassifier.cpp
+    DESCRIPTION: Implements the trackClassifier class, which gives each tracked ball a stable class from the evidence of all its detections.
+
+    CLASSES:
+    - class trackClassifier: Class evidence of every track and stable labels.
+
+    MAIN FUNCTIONS:
+    - trackClassifier(): Constructor to initialize the trackClassifier object with the default thresholds.
+    - void reset(...): Starts over with the given number of tracks, without evidence.
+    - void observe(...): Adds the pattern of a detection matched with a track (its per-frame class is a vote) and updates the class of the track.
+    - bool confident(...): True when the track has enough observations and a clear majority: its detections do not need to be analyzed again.
+    - int label(...): Class of a track (0 if never observed).
+    - std::vector<int> labels(): Classes of all the tracks, indexed as the trackers.
+    - BallPattern mean_pattern(...): Mean white and black percentages of a track, with its class.
+    - void print_stats(): Prints how many observations were used and how many were skipped for confident tracks.
+*/
+
+#include "trackClassifier.h"
+
+trackClassifier::trackClassifier(){
+    this->min_observations = 3;
+    this->min_confidence = 0.7;
+    this->observed = 0;
+    this->skipped = 0;
+}
+
+void trackClassifier::reset(size_t num_tracks){
+    classEvidence empty = {{0, 0, 0, 0, 0}, 0, 0.0, 0.0, 0};
+    this->tracks.assign(num_tracks, empty);
+}
+
+void trackClassifier::observe(size_t track, const BallPattern& pattern){
+    if (track >= this->tracks.size() || pattern.id < 1 || pattern.id > 4)
+        return;
+
+    classEvidence& evidence = this->tracks[track];
+    evidence.votes[pattern.id]++;
+    evidence.observations++;
+    evidence.white_sum += pattern.whitePercentage;
+    evidence.black_sum += pattern.blackPercentage;
+    this->observed++;
+
+    // Hysteresis: another class must get strictly more votes than the current one
+    if (evidence.label == 0 || evidence.votes[pattern.id] > evidence.votes[evidence.label])
+        evidence.label = pattern.id;
+}
+
+bool trackClassifier::confident(size_t track) const{
+    if (track >= this->tracks.size())
+        return false;
+
+    const classEvidence& evidence = this->tracks[track];
+    if (evidence.observations < this->min_observations || evidence.label == 0)
+        return false;
+    return evidence.votes[evidence.label] >= this->min_confidence * evidence.observations;
+}
+
+int trackClassifier::label(size_t track) const{
+    return track < this->tracks.size() ? this->tracks[track].label : 0;
+}
+
+std::vector<int> trackClassifier::labels() const{
+    std::vector<int> ids(this->tracks.size());
+    for (size_t i = 0; i < this->tracks.size(); ++i)
+        ids[i] = this->tracks[i].label;
+    return ids;
+}
+
+BallPattern trackClassifier::mean_pattern(size_t track) const{
+    const classEvidence& evidence = this->tracks[track];
+    if (evidence.observations == 0)
+        return {0.0, 0.0, evidence.label};
+    return {evidence.white_sum / evidence.observations, evidence.black_sum / evidence.observations, evidence.label};
+}
+
+size_t trackClassifier::size() const{
+    return this->tracks.size();
+}
+
+void trackClassifier::print_stats() const{
+    std::cout << "Ball classes: " << this->observed << " detections used, " << this->skipped << " skipped (confident tracks)" << std::endl;
+}
@@ -8,73 +8,96 @@
     - class trajectoryProjecter: Class for projecting the balls' trajectory onto a bird eye view minimap.
 
     FUNCTIONS:
-    - cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points): Computes the centroid of a given set of points.
-    - std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners): Sorts corners in clockwise order based on their angle from the centroid.
     - trajectoryProjecter::trajectoryProjecter(): Constructor for the trajectoryProjecter class.
-    - void trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectories, const std::vector<int>& id_balls, const std::vector<cv::Point2f>& corners): Projects ball positions and trajectories onto a table minimap and displays the result.
+    - void trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const std::vector<int>& id_balls, const cv::Mat& perspectiveMatrix): Projects ball positions and trajectories onto a table minimap and displays the result. `trajectoryTails` holds for every ball the last point already drawn followed by the new ones.
+    - std::vector<cv::Point2f> trajectoryProjecter::minimapCorners(): Returns the table corners on the minimap, the destination of the homography computed by `tableCalibration`.
+    - bool trajectoryProjecter::loadBackground(): Loads, resizes and converts the table minimap image. Called once.
+    - void trajectoryProjecter::drawNewSegments(...): Projects and draws on the trajectory layer the segments of the trajectory tails.
 
     NOTES:
     - The table minimap image should be placed in the "../res/" directory.
+    - The trajectories are accumulated on a persistent layer, so the cost per frame does not grow with the length of the clip. The output is the same as redrawing every trajectory from its first point.
+    - When the camera moves the old segments stay on the layer: they were projected with the homography of the view they were tracked in.
     - The function `projectBalls` overlays the table minimap image onto the bottom-left corner of the input frame.
     - Balls and their trajectories are drawn on the minimap image with colors assigned based on their IDs.
 */
 
 #include "trajectoryProjection.h"
 
-cv::Point2f computeCentroid(const std::vector<cv::Point2f>& points) {
-    cv::Point2f centroid(0, 0);
-    for (const auto& pt : points) {
-        centroid += pt;
-    }
-    centroid *= (1.0 / points.size());
-    return centroid;
-}
-
-std::vector<cv::Point2f> sortCornersClockwise(std::vector<cv::Point2f>& corners) {
-    // Calculate centroid
-    cv::Point2f centroid = computeCentroid(corners);
-
-    // Sort corners based on the angle they make with the centroid
-    std::sort(corners.begin(), corners.end(), [centroid](const cv::Point2f& a, const cv::Point2f& b) {
-        return std::atan2(a.y - centroid.y, a.x - centroid.x) < std::atan2(b.y - centroid.y, b.x - centroid.x);
-    });
+// Constructor of the class
+trajectoryProjecter::trajectoryProjecter() {
+    // Define the size for the table image on the frame
+    this->tableImageSize = cv::Size(MINIMAP_WIDTH, MINIMAP_HEIGHT);
 
-    return corners;
+    // Define a color map for different IDs
+    this->colorMap = {
+        {1, cv::Scalar(255, 255, 255)}, // White for ID 1
+        {2, cv::Scalar(0, 0, 0)},       // Black for ID 2
+        {3, cv::Scalar(0, 0, 255)},     // Red for ID 3
+        {4, cv::Scalar(255, 0, 0)},     // Blue for ID 4
+    };
 }
 
-// Constructor of the class
-trajectoryProjecter::trajectoryProjecter() {}
-
-cv::Mat trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectories, const std::vector<int>& id_balls, std::vector<cv::Point2f>& corners) {
+bool trajectoryProjecter::loadBackground() {
     // Load the table minimap image
     cv::Mat tableImage = cv::imread("../res/table.png", cv::IMREAD_UNCHANGED);
 
     if (tableImage.empty()) {
         std::cerr << "Error: Unable to load table image." << std::endl;
-        return cv::Mat{};
+        return false;
     }
 
-    // Define the size for the table image on the frame
-    cv::Size tableImageSize(300, 150);
+    // Resize the table minimap image
+    cv::resize(tableImage, this->background, tableImageSize);
+
+    // Ensure the background has 3 channels
+    if (this->background.channels() == 4) {
+        cv::cvtColor(this->background, this->background, cv::COLOR_BGRA2BGR);
+    }
+
+    this->trajectoryLayer = this->background.clone();
+    return true;
+}
 
+std::vector<cv::Point2f> trajectoryProjecter::minimapCorners() {
     // Adjust the translation onto the minimap with respect to the chosen base image
     int tableBorderWidth_horizontal = 10;
     int tableBorderWidth_vertical = 15;
 
     std::vector<cv::Point2f> dstCorners = {
         cv::Point2f(tableBorderWidth_horizontal, tableBorderWidth_vertical),
-        cv::Point2f(tableImageSize.width - tableBorderWidth_horizontal, tableBorderWidth_vertical),
-        cv::Point2f(tableImageSize.width - tableBorderWidth_horizontal, tableImageSize.height - tableBorderWidth_vertical),
-        cv::Point2f(tableBorderWidth_horizontal, tableImageSize.height - tableBorderWidth_vertical)
+        cv::Point2f(MINIMAP_WIDTH - tableBorderWidth_horizontal, tableBorderWidth_vertical),
+        cv::Point2f(MINIMAP_WIDTH - tableBorderWidth_horizontal, MINIMAP_HEIGHT - tableBorderWidth_vertical),
+        cv::Point2f(tableBorderWidth_horizontal, MINIMAP_HEIGHT - tableBorderWidth_vertical)
     };
+    return dstCorners;
+}
 
-    // Resize the table minimap image
-    cv::Mat resizedTableImage;
-    cv::resize(tableImage, resizedTableImage, tableImageSize);
+void trajectoryProjecter::drawNewSegments(const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const cv::Mat& perspectiveMatrix) {
+    for (size_t i = 0; i < trajectoryTails.size(); ++i) {
+        const std::vector<cv::Point2f>& tail = trajectoryTails[i];
+        if (tail.size() < 2)
+            continue;   // no new segment for this ball
+
+        // Transform only the points not drawn yet
+        try {
+            cv::perspectiveTransform(tail, this->birdEyePoints, perspectiveMatrix);
+        } catch (const cv::Exception& e) {
+            std::cerr << "Error in perspectiveTransform for trajectory " << i << ": " << e.what() << std::endl;
+            continue;
+        }
+
+        // Draw the trajectory on the bird's-eye view layer
+        for (size_t j = 1; j < this->birdEyePoints.size(); ++j) {
+            cv::line(this->trajectoryLayer, this->birdEyePoints[j - 1], this->birdEyePoints[j], cv::Scalar(0, 255, 255), 2);
+        }
+    }
+}
 
-    // Ensure resizedTableImage has 3 channels
-    if (resizedTableImage.channels() == 4) {
-        cv::cvtColor(resizedTableImage, resizedTableImage, cv::COLOR_BGRA2BGR);
+cv::Mat trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vector<cv::Point2f>& balls, const std::vector<std::vector<cv::Point2f>>& trajectoryTails, const std::vector<int>& id_balls, const cv::Mat& perspectiveMatrix) {
+    // Load the background only once
+    if (this->background.empty() && !this->loadBackground()) {
+        return cv::Mat{};
     }
 
     // Define the region where the table minimap image will be placed (bottom-left corner)
@@ -86,90 +109,39 @@ cv::Mat trajectoryProjecter::projectBalls(const cv::Mat& frame, const std::vecto
         return cv::Mat{};
     }
 
-    // Ensure the resized table image fits into the ROI
-    if (resizedTableImage.size() != cv::Size(roi.width, roi.height)) {
-        std::cerr << "Error: Resized table image size does not match the ROI size." << std::endl;
-        return cv::Mat{};
-    }
-
-    // Ensure corners are sorted clockwise
-    corners = sortCornersClockwise(corners);
-
-    // Compute perspective transform matrix
-    cv::Mat perspectiveMatrix = cv::getPerspectiveTransform(corners, dstCorners);
-
-    // Transform reference points to get original frame coordinates
-    std::vector<cv::Point2f> transformedCorners(4);
-    cv::perspectiveTransform(dstCorners, transformedCorners, perspectiveMatrix);
-
-    // Compute diagonal lengths of the transformed rectangle
-    double diagonal1Length = cv::norm(transformedCorners[2] - transformedCorners[0]); // Top-left to bottom-right
-    double diagonal2Length = cv::norm(transformedCorners[3] - transformedCorners[1]); // Top-right to bottom-left
-
-    // Determine table orientation
-    bool isVertical = (diagonal1Length > diagonal2Length);
-    std::string orientationText = isVertical ? "Vertical" : "Horizontal";
-
-    // Adjust perspective matrix for vertical table
-    if (isVertical) {
-        std::rotate(corners.begin(), corners.begin() + 1, corners.end());
-        perspectiveMatrix = cv::getPerspectiveTransform(corners, dstCorners);
-    }
-
-    // Transform the ball positions
     std::vector<cv::Point2f> birdEyeBallPositions;
 
-    try {
-        cv::perspectiveTransform(balls, birdEyeBallPositions, perspectiveMatrix);
-    } catch (const cv::Exception& e) {
-        std::cerr << "Error in perspectiveTransform for balls: " << e.what() << std::endl;
-    }
-
-    // Transform the trajectories
-    std::vector<std::vector<cv::Point2f>> birdEyeTrajectories(trajectories.size());
+    if (!perspectiveMatrix.empty()) {
+        // Add the newest segment of every trajectory to the persistent layer
+        this->drawNewSegments(trajectoryTails, perspectiveMatrix);
 
-    for (size_t i = 0; i < trajectories.size(); ++i) {
+        // Transform the ball positions
         try {
-            cv::perspectiveTransform(trajectories[i], birdEyeTrajectories[i], perspectiveMatrix);
+            cv::perspectiveTransform(balls, birdEyeBallPositions, perspectiveMatrix);
         } catch (const cv::Exception& e) {
-            std::cerr << "Error in perspectiveTransform for trajectory " << i << ": " << e.what() << std::endl;
+            std::cerr << "Error in perspectiveTransform for balls: " << e.what() << std::endl;
         }
     }
 
-    // Define a color map for different IDs
-    std::map<int, cv::Scalar> colorMap = {
-        {1, cv::Scalar(255, 255, 255)}, // White for ID 1
-        {2, cv::Scalar(0, 0, 0)},       // Black for ID 2
-        {3, cv::Scalar(0, 0, 255)},     // Red for ID 3
-        {4, cv::Scalar(255, 0, 0)},     // Blue for ID 4
-    };
+    // Create a copy of the frame to avoid modifying the original frame
+    cv::Mat frameWithOverlay = frame.clone();
 
-    // Draw the trajectories on the bird's-eye view
-    for (const auto& trajectory : birdEyeTrajectories) {
-        for (size_t j = 1; j < trajectory.size(); ++j) {
-            cv::line(resizedTableImage, trajectory[j - 1], trajectory[j], cv::Scalar(0, 255, 255), 2);
-        }
-    }
+    // Place the trajectory layer on the bottom-left corner of the frame
+    cv::Mat minimap = frameWithOverlay(roi);
+    this->trajectoryLayer.copyTo(minimap);
 
-    // Draw the balls on the resized minimap table image before overlaying
+    // Draw the balls on top of the trajectories
     for (size_t i = 0; i < birdEyeBallPositions.size(); ++i) {
         int id = id_balls[i];
         // Ensure the ID exists in the color map
-        if (colorMap.find(id) != colorMap.end()) {
-            cv::Scalar color = colorMap[id]; // Assign color based on ID
+        std::map<int, cv::Scalar>::const_iterator color = this->colorMap.find(id);
+        if (color != this->colorMap.end()) {
             cv::Point2f pos = birdEyeBallPositions[i];
-            cv::circle(resizedTableImage, pos, 5, color, -1);
+            cv::circle(minimap, pos, 5, color->second, -1);
         } else {
             std::cerr << "Warning: ID " << id << " not found in color map!" << std::endl;
         }
     }
-
-
-    // Create a copy of the frame to avoid modifying the original frame
-    cv::Mat frameWithOverlay = frame.clone();
-
-    // Place the resized table image on the bottom-left corner of the frame
-    resizedTableImage.copyTo(frameWithOverlay(roi));
     
     return frameWithOverlay;
-}
+}
\ No newline at end of file
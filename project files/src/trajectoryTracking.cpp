@@ -2,7 +2,7 @@
     AUTHOR: Girardello Sofia
     DATE: 2024-07-21 
     FILE: trajectoryTracking.cpp
-    DESCRIPTION: Implements the trajectory tracking class using OpenCV trackers.
+    DESCRIPTION: Implements the trajectory tracking class using one ballTracker per ball.
 
     CLASSES:
     - class trajectoryTracker: Class for tracking the trajectories of multiple objects.
@@ -11,49 +11,307 @@
     - trajectoryTracker(): Constructor to initialize the trajectoryTracker object.
     - void initializeTrackers(...): Initializes trackers for the given bounding boxes.
     - void updateTrackers(...): Updates the trackers with the current frame and stores the centers and trajectories.
+    - void resyncTrackers(...): Restarts the trackers that got a new box (e.g. from a new detection), keeping their history.
+    - void skipFrames(...): Advances the frame counter over frames that are not analyzed (temporal stride). Their positions are interpolated at the next update.
+    - double max_displacement(): Largest move of a ball between the last two analyzed frames, in px.
+    - void set_input_transform(...): Sets where the frames given to the trackers come from (offset of the region in the full frame, scale factor). Boxes in, boxes and points out are always in full frame coordinates.
+    - cv::Rect last_bbox(...): Box of the i-th ball at its last successful update.
+    - void reserve_history(...): Reserves the history of every ball for the given number of frames.
+    - void set_backend(...): Selects the backend of the trackers created from now on.
+    - void set_thread_budget(...): Sets how many threads initialize and update the trackers (0 = machine size, 1 = serial).
+    - void forEachTracker(...): Runs the given body for every tracker index on the pool, or serially without a pool.
+    - void set_motion_threshold(...): Sets the motion gating threshold (0 = always update).
+    - const gatingStats& gating_stats(): Counters of the motion gating.
+    - bool ballMoved(...): Motion gating check of the i-th ball on the current frame.
+    - void set_pockets(...): Places the six pockets from the four table corners (corners plus the middle of the long sides).
+    - trackState state(...): Lifecycle state of the i-th ball.
+    - trackCounts track_counts(): Number of balls in every state.
+    - bool reacquire(...): Bounded local search of a lost ball around its last box, by template matching of its last appearance.
+    - bool nearPocket(...): True if the given point is within `pocket_radius` of a pocket.
+    - cv::Rect toInput(...) / toFrame(...): Box from full frame to input coordinates and back.
+    - size_t num_trajectories(): Number of tracked balls.
+    - trajectoryView trajectory(...): View on the history of the i-th ball (i = tracker index).
 */
 
 #include "trajectoryTracking.h"
-#include <opencv2/tracking.hpp>
+#include "tableCalibration.h"
+#include <algorithm>
 
 // Constructor of the class
 trajectoryTracker::trajectoryTracker() {
+    this->reserved_frames = 0;
+    this->frame_index = 0;
+    this->last_update_frame = 0;
+    this->max_step = 0.0;
+    this->backend = TRACKER_CSRT;
+    this->motion_threshold = 0.0;
+    this->stats = gatingStats();
+    this->pocket_radius = 0.0;
+    this->input_offset = cv::Point2f(0.0f, 0.0f);
+    this->input_scale = 1.0;
+    this->verbose = true;
+}
+
+
+// Gray copy of the part of the frame under the box
+static void extractPatch(const cv::Mat& frame, const cv::Rect& bbox, cv::Mat& patch) {
+    cv::Rect roi = bbox & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (frame.channels() == 3)
+        cv::cvtColor(frame(roi), patch, cv::COLOR_BGR2GRAY);
+    else
+        frame(roi).copyTo(patch);
+}
+
+
+void trajectoryTracker::set_motion_threshold(double threshold) {
+    this->motion_threshold = threshold;
+}
+
+
+const gatingStats& trajectoryTracker::gating_stats() const {
+    return this->stats;
+}
+
+
+bool trajectoryTracker::ballMoved(const cv::Mat& frame, size_t i) {
+    if (this->motion_threshold <= 0.0 || this->reference_patches[i].empty())
+        return true;
+
+    cv::Mat& patch = this->current_patches[i];
+    extractPatch(frame, this->last_bboxes[i], patch);
+    if (patch.size() != this->reference_patches[i].size() || patch.empty())
+        return true;
+
+    double sad = cv::norm(patch, this->reference_patches[i], cv::NORM_L1);
+    return sad / patch.total() >= this->motion_threshold;
+}
+
+
+void trajectoryTracker::set_pockets(const std::vector<cv::Point2f>& table_corners) {
+    this->pockets.clear();
+    if (table_corners.size() != 4)
+        return;
+
+    std::vector<cv::Point2f> corners = table_corners;
+    sortCornersClockwise(corners);
+
+    // Corner pockets, plus the middle pockets of the two long sides
+    double side_a = cv::norm(corners[1] - corners[0]);
+    double side_b = cv::norm(corners[2] - corners[1]);
+    int first = side_a >= side_b ? 0 : 1;
+    this->pockets = corners;
+    this->pockets.push_back((corners[first] + corners[first + 1]) * 0.5f);
+    this->pockets.push_back((corners[first + 2] + corners[(first + 3) % 4]) * 0.5f);
+
+    // About two ball diameters on the usual table sizes
+    this->pocket_radius = 0.08 * std::min(side_a, side_b);
+}
+
+
+cv::Rect trajectoryTracker::toInput(const cv::Rect& bbox) const {
+    return cv::Rect(cvRound((bbox.x - this->input_offset.x) * this->input_scale), cvRound((bbox.y - this->input_offset.y) * this->input_scale),
+                    std::max(1, cvRound(bbox.width * this->input_scale)), std::max(1, cvRound(bbox.height * this->input_scale)));
+}
+
+
+cv::Rect trajectoryTracker::toFrame(const cv::Rect& bbox) const {
+    return cv::Rect(cvRound(bbox.x / this->input_scale + this->input_offset.x), cvRound(bbox.y / this->input_scale + this->input_offset.y),
+                    cvRound(bbox.width / this->input_scale), cvRound(bbox.height / this->input_scale));
+}
+
+
+void trajectoryTracker::set_input_transform(const cv::Point2f& offset, double scale) {
+    if (offset == this->input_offset && scale == this->input_scale)
+        return;
+
+    // The boxes follow the input, the trackers are restarted on it at the next update
+    for (size_t i = 0; i < this->last_bboxes.size(); ++i)
+        this->last_bboxes[i] = toFrame(this->last_bboxes[i]);
+    this->input_offset = offset;
+    this->input_scale = scale;
+    for (size_t i = 0; i < this->last_bboxes.size(); ++i) {
+        this->last_bboxes[i] = toInput(this->last_bboxes[i]);
+        this->restart_pending[i] = 1;
+    }
+}
+
+
+bool trajectoryTracker::nearPocket(const cv::Rect& input_bbox) const {
+    cv::Rect bbox = toFrame(input_bbox);
+    cv::Point2f center(bbox.x + bbox.width / 2.0f, bbox.y + bbox.height / 2.0f);
+    for (const cv::Point2f& pocket : this->pockets) {
+        if (cv::norm(center - pocket) < this->pocket_radius)
+            return true;
+    }
+    return false;
+}
+
+
+bool trajectoryTracker::reacquire(const cv::Mat& frame, size_t i) {
+    const cv::Mat& templ = this->reference_patches[i];
+    const cv::Rect& last = this->last_bboxes[i];
+    if (templ.empty() || templ.size() != last.size())
+        return false;
+
+    // Window around the last box, growing with the frames since the loss
+    int margin = std::max(1, cvRound(std::min(MAX_SEARCH_MARGIN, SEARCH_MARGIN * (this->lost_frames[i] + 1)) * this->input_scale));
+    cv::Rect window = cv::Rect(last.x - margin, last.y - margin, last.width + 2*margin, last.height + 2*margin) & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (window.width < templ.cols || window.height < templ.rows)
+        return false;
+
+    extractPatch(frame, window, this->search_windows[i]);
+    cv::matchTemplate(this->search_windows[i], templ, this->search_responses[i], cv::TM_CCOEFF_NORMED);
+    double best;
+    cv::Point best_loc;
+    cv::minMaxLoc(this->search_responses[i], nullptr, &best, nullptr, &best_loc);
+    if (best < REACQUIRE_SCORE)
+        return false;
+
+    // Found: restart the tracker there
+    cv::Rect bbox(window.x + best_loc.x, window.y + best_loc.y, last.width, last.height);
+    cv::Ptr<ballTracker> tracker = createBallTracker(this->backend);
+    tracker->init(frame, bbox);
+    this->trackers[i] = tracker;
+    this->last_bboxes[i] = bbox;
+    extractPatch(frame, bbox, this->reference_patches[i]);
+    return true;
+}
+
+
+trackState trajectoryTracker::state(size_t i) const {
+    return this->states[i];
+}
+
+
+trackCounts trajectoryTracker::track_counts() const {
+    trackCounts counts = {0, 0, 0, 0};
+    for (trackState state : this->states) {
+        switch (state) {
+            case TRACK_ACTIVE: counts.active++; break;
+            case TRACK_LOST: counts.lost++; break;
+            case TRACK_POCKETED: counts.pocketed++; break;
+            case TRACK_RETIRED: counts.retired++; break;
+        }
+    }
+    return counts;
+}
+
+
+void trajectoryTracker::set_backend(trackerBackend backend) {
+    this->backend = backend;
+}
+
+
+void trajectoryTracker::set_thread_budget(int threads) {
+    // 0 = one thread per hardware thread
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (threads == 1)
+        this->pool.reset();
+    else
+        this->pool = std::make_shared<workerPool>(threads);
+}
+
+
+void trajectoryTracker::forEachTracker(int count, const std::function<void(int)>& body) {
+    if (this->pool)
+        this->pool->parallel_for(count, body);
+    else {
+        for (int i = 0; i < count; ++i)
+            body(i);
+    }
+}
+
+
+void trajectoryTracker::reserve_history(size_t frames) {
+    this->reserved_frames = frames;
+    for (ballHistory& history : this->ballTrajectories) {
+        history.points.reserve(frames);
+        history.frames.reserve(frames);
+        history.interpolated.reserve(frames);
+    }
+}
+
+
+size_t trajectoryTracker::num_trajectories() const {
+    return this->ballTrajectories.size();
+}
+
+
+trajectoryView trajectoryTracker::trajectory(size_t i) const {
+    const ballHistory& history = this->ballTrajectories[i];
+    trajectoryView view;
+    view.points = history.points.data();
+    view.frames = history.frames.data();
+    view.interpolated = history.interpolated.data();
+    view.length = history.points.size();
+    return view;
+}
+
+
+void trajectoryTracker::skipFrames(int frames) {
+    this->frame_index += std::max(0, frames);
+}
+
+
+double trajectoryTracker::max_displacement() const {
+    return this->max_step;
+}
+
+
+cv::Rect trajectoryTracker::last_bbox(size_t i) const {
+    return toFrame(this->last_bboxes[i]);
+}
+
+
+void trajectoryTracker::resyncTrackers(const cv::Mat& frame, const std::vector<cv::Rect>& bboxes) {
+
+    // Empty box = keep the current tracker
+    int count = static_cast<int>(std::min(bboxes.size(), this->trackers.size()));
+    this->forEachTracker(count, [&](int i) {
+            if (bboxes[i].area() <= 0)
+                return;
+            cv::Rect bbox = toInput(bboxes[i]);
+            cv::Ptr<ballTracker> tracker = createBallTracker(this->backend);
+            tracker->init(frame, bbox);
+            this->trackers[i] = tracker;
+            extractPatch(frame, bbox, this->reference_patches[i]);
+            this->last_bboxes[i] = bbox;
+            this->restart_pending[i] = 0;
+            this->states[i] = TRACK_ACTIVE;
+            this->lost_frames[i] = 0;
+    });
 }
 
 
 void trajectoryTracker::initializeTrackers(const cv::Mat& frame, const std::vector<cv::Rect>& initial_bboxes){
 
-    // Definition of the parameters defining the trackers
-    cv::TrackerCSRT::Params csrtParams;
-    csrtParams.use_hog = true;               // Use HOG features
-    csrtParams.use_color_names = true;       // Use Color Names features
-    csrtParams.use_gray = true;              // Use Gray features
-    csrtParams.use_rgb = true;               // Use RGB features
-    csrtParams.use_channel_weights = true;   // Use Channel Weights
-    csrtParams.use_segmentation = true;      // Use Segmentation
-    csrtParams.window_function = "hann";     // Window function
-    csrtParams.kaiser_alpha = 4.75;          // Kaiser window parameter
-    csrtParams.cheb_attenuation = 45;        // Chebyshev window parameter
-    csrtParams.template_size = 400;          // Template size
-    csrtParams.gsl_sigma = 2.0;              // Gaussian window parameter
-    csrtParams.hog_orientations = 9;         // HOG orientations
-    csrtParams.num_hog_channels_used = 18;   // Number of HOG channels
-    csrtParams.filter_lr = 0.03;             // Learning rate for the filter
-    csrtParams.weights_lr = 0.03;            // Learning rate for the weights
-    csrtParams.admm_iterations = 7;          // Number of ADMM iterations
-    csrtParams.number_of_scales = 33;        // Number of scales
-    csrtParams.scale_sigma_factor = 0.25;    // Scale sigma factor
-    csrtParams.scale_model_max_area = 512;   // Scale model max area
-    csrtParams.scale_lr = 0.001;             // Scale learning rate
-    csrtParams.scale_step = 1.01;            // Scale step
-    csrtParams.psr_threshold = 0.05;         // PSR threshold
-
-
-    for (const cv::Rect& bbox : initial_bboxes) {
-            cv::Ptr<cv::Tracker> tracker = cv::TrackerCSRT::create(csrtParams);
+    // Every tracker gets its own slot, so they can be created and initialized in parallel
+    size_t first = this->trackers.size();
+    this->trackers.resize(first + initial_bboxes.size());
+    this->last_bboxes.resize(first + initial_bboxes.size());
+    this->reference_patches.resize(first + initial_bboxes.size());
+    this->current_patches.resize(first + initial_bboxes.size());
+    this->states.resize(first + initial_bboxes.size(), TRACK_ACTIVE);
+    this->lost_frames.resize(first + initial_bboxes.size(), 0);
+    this->search_windows.resize(first + initial_bboxes.size());
+    this->search_responses.resize(first + initial_bboxes.size());
+    this->restart_pending.resize(first + initial_bboxes.size(), 0);
+    this->forEachTracker(static_cast<int>(initial_bboxes.size()), [&](int i) {
+            cv::Rect bbox = toInput(initial_bboxes[i]);
+            cv::Ptr<ballTracker> tracker = createBallTracker(this->backend);
             tracker->init(frame, bbox);
-            this->trackers.push_back(tracker);
-            this->ballTrajectories.push_back(std::vector<cv::Point2f>());
+            this->trackers[first + i] = tracker;
+            extractPatch(frame, bbox, this->reference_patches[first + i]);
+            this->last_bboxes[first + i] = bbox;
+    });
+
+    for (size_t i = 0; i < initial_bboxes.size(); ++i) {
+            this->ballTrajectories.push_back(ballHistory());
+            this->ballTrajectories.back().points.reserve(this->reserved_frames);
+            this->ballTrajectories.back().frames.reserve(this->reserved_frames);
+            this->ballTrajectories.back().interpolated.reserve(this->reserved_frames);
     }
 
 }
@@ -61,40 +319,136 @@ void trajectoryTracker::initializeTrackers(const cv::Mat& frame, const std::vect
 
    void trajectoryTracker::updateTrackers(const cv::Mat& frame) {
 
-        // Clear previous centers and trajectories
+        // Clear previous centers (the capacity is kept, no allocation after the first frame)
         this->centers.clear();
-        this->trajectories.clear();
+        this->center_tracks.clear();
+        this->frame_index++;
+        this->previous_states = this->states;
+
+        // Update all trackers, in parallel: each one writes only its own result slot
+        size_t num_trackers = this->trackers.size();
+        this->update_ok.resize(num_trackers);
+        this->update_bboxes.resize(num_trackers);
+        this->update_skipped.resize(num_trackers);
+        this->forEachTracker(static_cast<int>(num_trackers), [&](int i) {
+
+            // Balls off the table: no work at all
+            if (this->states[i] == TRACK_POCKETED || this->states[i] == TRACK_RETIRED) {
+                this->update_skipped[i] = 0;
+                this->update_ok[i] = 0;
+                return;
+            }
 
-        // Update all trackers
-        for (size_t i = 0; i < this->trackers.size(); ++i) {
-            cv::Rect bbox;
-            bool ok = this->trackers[i]->update(frame, bbox);
+            // New input region: the tracker starts again from its last box, moved to the new input
+            if (this->restart_pending[i]) {
+                this->restart_pending[i] = 0;
+                if (this->states[i] == TRACK_ACTIVE) {
+                    cv::Ptr<ballTracker> tracker = createBallTracker(this->backend);
+                    tracker->init(frame, this->last_bboxes[i]);
+                    this->trackers[i] = tracker;
+                }
+            }
+
+            // Lost ball: bounded search around its last box
+            if (this->states[i] == TRACK_LOST) {
+                this->update_skipped[i] = 0;
+                this->update_ok[i] = this->reacquire(frame, i);
+                if (this->update_ok[i]) {
+                    this->states[i] = TRACK_ACTIVE;
+                    this->lost_frames[i] = 0;
+                    this->update_bboxes[i] = this->last_bboxes[i];
+                } else if (++this->lost_frames[i] > MAX_LOST_FRAMES) {
+                    this->states[i] = this->nearPocket(this->last_bboxes[i]) ? TRACK_POCKETED : TRACK_RETIRED;
+                }
+                return;
+            }
+
+            // Still ball: keep the last position, no tracker update
+            if (!this->ballMoved(frame, i)) {
+                this->update_skipped[i] = 1;
+                this->update_ok[i] = 1;
+                this->update_bboxes[i] = this->last_bboxes[i];
+                return;
+            }
+
+            this->update_skipped[i] = 0;
+            this->update_ok[i] = this->trackers[i]->update(frame, this->update_bboxes[i]);
+            if (this->update_ok[i]) {
+                this->last_bboxes[i] = this->update_bboxes[i];
+                extractPatch(frame, this->last_bboxes[i], this->reference_patches[i]);
+            } else {
+                // Failure next to a pocket: the ball went in
+                this->states[i] = this->nearPocket(this->last_bboxes[i]) ? TRACK_POCKETED : TRACK_LOST;
+                this->lost_frames[i] = 0;
+            }
+        });
+
+        this->stats.updated = 0;
+        this->stats.skipped = 0;
+        this->max_step = 0.0;
+
+        // Collect the results in tracker order, independently of the scheduling
+        for (size_t i = 0; i < num_trackers; ++i) {
+            cv::Rect bbox = toFrame(this->update_bboxes[i]);
+            bool ok = this->update_ok[i];
+            if (this->update_skipped[i])
+                this->stats.skipped++;
+            else if (this->previous_states[i] == TRACK_ACTIVE)
+                this->stats.updated++;
             if (ok) {
 
 
                 cv::Point2f center(bbox.x + bbox.width / 2, bbox.y + bbox.height / 2);
-                this->ballTrajectories[i].push_back(center);
+                ballHistory& history = this->ballTrajectories[i];
+
+                // Tracked at the last update too: fill the skipped frames at constant velocity
+                if (!history.frames.empty() && history.frames.back() == this->last_update_frame) {
+                    cv::Point2f previous = history.points.back();
+                    int gap = this->frame_index - this->last_update_frame;
+                    for (int k = 1; k < gap; ++k) {
+                        history.points.push_back(previous + (center - previous) * (static_cast<float>(k) / gap));
+                        history.frames.push_back(this->last_update_frame + k);
+                        history.interpolated.push_back(1);
+                    }
+                    this->max_step = std::max(this->max_step, cv::norm(center - previous));
+                }
+
+                history.points.push_back(center);
+                history.frames.push_back(this->frame_index);
+                history.interpolated.push_back(0);
 
                 /* --Debug
                 // Draw bounding box
                 cv::rectangle(frame, bbox, cv::Scalar(255, 0, 0), 2, 1);
                 // Draw the trajectory
-                for (size_t j = 1; j < this->ballTrajectories[i].size(); ++j) {
-                    cv::line(frame, this->ballTrajectories[i][j - 1], this->ballTrajectories[i][j], cv::Scalar(0, 255, 0), 2);
+                for (size_t j = 1; j < this->ballTrajectories[i].points.size(); ++j) {
+                    cv::line(frame, this->ballTrajectories[i].points[j - 1], this->ballTrajectories[i].points[j], cv::Scalar(0, 255, 0), 2);
                 }
                 // Draw the center
                 cv::circle(frame, center, 5, cv::Scalar(0, 255, 0), -1);
                 */
 
-                // Store the center and trajectory
+                // Store the center
                 this->centers.push_back(center);
-                this->trajectories.push_back(this->ballTrajectories[i]);
+                this->center_tracks.push_back(i);
 
-            } else {
-                std::cout << "Tracker " << i << " lost the object!" << std::endl;
+            }
+
+            // Report the changes of state only (not in batch runs, where the clips print at the same time)
+            if (this->verbose && this->states[i] != this->previous_states[i]) {
+                switch (this->states[i]) {
+                    case TRACK_LOST: std::cout << "Tracker " << i << " lost the object!" << std::endl; break;
+                    case TRACK_POCKETED: std::cout << "Tracker " << i << ": ball pocketed." << std::endl; break;
+                    case TRACK_RETIRED: std::cout << "Tracker " << i << " retired." << std::endl; break;
+                    case TRACK_ACTIVE: std::cout << "Tracker " << i << " found the object again." << std::endl; break;
+                }
             }
         }
 
+        this->stats.tot_updated += this->stats.updated;
+        this->stats.tot_skipped += this->stats.skipped;
+        this->last_update_frame = this->frame_index;
+
         /* --Debug
         cv::imshow("Ball Tracking", frame);
         cv::waitKey(1);*/
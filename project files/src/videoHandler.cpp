@@ -10,7 +10,12 @@
     - videoHandler(const std::string& folder_name): Constructor that initializes the `videoHandler` object by setting up paths and loading necessary files based on the provided folder name.
     - void load_files(): Loads segmentation mask and bounding box data for the first and last frames. Handles errors if files cannot be loaded.
     - cv::Mat load_txt_data(...): Reads bounding box data from a text file and stores it in a `cv::Mat` matrix.
-    - void process_video(...): Processes the video file frame by frame. Calls `frameHandler` to perform table and ball detection. Displays intermediate results based on the `MIDSTEP_flag` and writes processed frames to an output video file.
+    - void attach_sink(...): Attaches an optional sink (e.g. the interactive preview) that receives the processed frames. Without a sink the video is processed headless.
+    - void process_video(...): Processes the video file frame by frame. Calls `frameHandler` to perform table and ball detection. Forwards intermediate results to the attached sink based on the `MIDSTEP_flag`, writes processed frames to an output video file and reports wall time and fps.
+    - int run_sequential(...): Runs decode, analysis, render and encode one after the other on the calling thread. With a temporal stride the frames between two analyzed ones are only grabbed, and the last output frame is written again for each of them.
+    - int run_pipelined(...): Runs decode, analysis and render on their own threads and encodes on the calling thread. Stages are connected by bounded lock-free queues of recycled frame buffers.
+    - void analyze_frame(...) / render_frame(...) / collect_frame(...): The three steps shared by both runs, so that the pipelined output is identical to the sequential one.
+    - void finish_run(...): Reports of the analysis at the end of both runs (tracker statistics, shot timeline, stage latencies) and saves the trajectories.
     - cv::Mat displayMask(...): Converts and displays segmentation masks using a predefined color map for different classes.
     - cv::Mat plot_bb(...): Draws bounding boxes on the source image using colors based on class labels.
 
@@ -19,8 +24,13 @@
 
     IMPORTANT:
     - Ensure the paths and file names used in `load_files` match the actual dataset structure.
-    - The output video and metrics are saved to the `../build/output` directory. Ensure this directory is writable.
+    - The output video and metrics are saved to the `../build/output` directory. Ensure this directory is writable. With `shot_events` the shot timeline is saved there too, as `<folder_name>_shots.txt`. The trajectories are always saved, as `<folder_name>_trajectories.txt`. With `timings_json` the stage latencies are saved as `<folder_name>_timings.json`.
     - The `MIDSTEP_flag` allows toggling between visualizing all frames or just the first and last frames for debugging purposes.
+    - With `redetect_interval` = K the balls are also detected every K frames and the drifted trackers are restarted on the detections, which bounds the drift of a tracker to K frames.
+    - With `frame_stride` > 1 the video always runs sequentially: the next analyzed frame depends on the motion measured on the current one.
+    - `videoHandler` holds no static or shared state: several instances can process different clips at the same time in one process (see `batchRunner`).
+    - Decode (grab for the frames skipped by the stride) and encode are timed with `TIME_STAGE` in both runs, next to the stages of `frameHandler`.
+    - The pipelined run keeps the frame order and produces the same output video as the sequential one. Queue statistics are printed at the end to spot the bottleneck stage.
 */
 
 #include "videoHandler.h"
@@ -30,9 +40,18 @@
 videoHandler::videoHandler(const std::string& folder_name) {
     this->errors = false;
     this->folder_name = folder_name;
+    this->sink = nullptr;
+    this->frames_processed = 0;
+    this->elapsed_s = 0.0;
+    this->mAP = 0.0;
+    this->mIoU = 0.0;
     this->load_files();
 }
 
+void videoHandler::attach_sink(frameSink* sink) {
+    this->sink = sink;
+}
+
 void videoHandler::load_files() {
     std::string mask_path = "../res/Dataset/" + folder_name + "/masks/";
     this->ffirst_mask = cv::imread(mask_path + "frame_first.png", cv::IMREAD_GRAYSCALE);
@@ -79,7 +98,7 @@ cv::Mat videoHandler::load_txt_data(const std::string& path){
     return data_matrix;
 }
 
-void videoHandler::process_video(int MIDSTEP_flag){
+void videoHandler::process_video(const processingOptions& options){
     std::string folder_path = "../res/Dataset/" + folder_name;
     std::string video_path = folder_path + "/" + folder_name + ".mp4";
 
@@ -100,7 +119,8 @@ void videoHandler::process_video(int MIDSTEP_flag){
     int frame_height = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
     cv::Size frame_size(frame_width, frame_height);
 
-    std::cout << "codec: " << codec << std::endl << "fps: " << fps << std::endl << "tot_frames: " << tot_frames << std::endl << "frame_size: " << frame_size << std::endl;
+    if (options.verbose){
+        std::cout << "codec: " << codec << std::endl << "fps: " << fps << std::endl << "tot_frames: " << tot_frames << std::endl << "frame_size: " << frame_size << std::endl;}
 
     // Create output folder inside build inside the root project path
     std::string build_folder = "../build";
@@ -124,74 +144,29 @@ void videoHandler::process_video(int MIDSTEP_flag){
         return;
     }
 
-    int i = 1;
-    cv::Mat frame_i, ret_frame;
-    frameHandler frame_handler = frameHandler();
-    std::vector<cv::Point2f> table_corners; 
-
-    while (i <= tot_frames) {
-        capture >> frame_i;
-        std::cout << "frame " << i << "/" << tot_frames << std::endl;
-
-        // Elaborate video - call frameHandler --------------------
-
-        // Runs only for first frame or every if MIDSTEP_flag==true
-        if (i==1 || i==tot_frames || MIDSTEP_flag){
-            frame_handler.detect_table(frame_i);
-            if (i==1){
-                frame_handler.save_table_corners();}
-            frame_handler.detect_balls(frame_i);
-            if (i==1){
-                frame_handler.initializeTrackers(frame_i);
-                frame_handler.save_ids();
-            }
-        }
+    int64 start_ticks = cv::getTickCount();
 
-        // Runs for every frame
-        frame_handler.updateTrackers(frame_i);
-        cv::Mat w_borders_on = frame_handler.draw_frame(frame_i);
-        ret_frame = frame_handler.project(w_borders_on);
-        cv::namedWindow("frame_i"); cv::imshow("frame_i", ret_frame);  
-        cv::waitKey(1);
-        
-        //SAVES ONLY FIRST AND LAST
-        if (i==1 || i==tot_frames || MIDSTEP_flag){
-            if (i==1){
-                this->ffirst_ret_bb = frame_handler.bbox_data;
-                this->ffirst_ret_mask = frame_handler.classification_res;
-                
-            }
-            else if(i==tot_frames){
-                this->flast_ret_bb = frame_handler.bbox_data;
-                this->flast_ret_mask = frame_handler.classification_res;
-            }
+    int frames_done;
+    if (options.pipelined && options.frame_stride <= 1){
+        frames_done = this->run_pipelined(capture, writer, tot_frames, options);}
+    else{
+        frames_done = this->run_sequential(capture, writer, tot_frames, options);}
 
-            cv::namedWindow("bb"); cv::imshow("bb", this->plot_bb(w_borders_on, frame_handler.bbox_data));
-            cv::namedWindow("mask"); cv::imshow("mask", this->displayMask(frame_handler.classification_res));
-            
-            if (i==1 || i==tot_frames){
-                std::cout << "Press any key to proceed..." << std::endl;
-                cv::waitKey(0);
-            }
-        }
+    this->elapsed_s = (cv::getTickCount() - start_ticks) / cv::getTickFrequency();
+    this->frames_processed = frames_done;
 
-        //-------------------------------------------------------
-        
-        writer.write(ret_frame);
-        i++;
+    if (options.verbose){
+        std::cout << "Process exited from loop after " << frames_done << " frames elaborated." << std::endl;
+        std::cout << "Wall time: " << this->elapsed_s << " s (" << this->frames_processed / this->elapsed_s << " fps)" << std::endl;
     }
-
-    std::cout << "Process exited from loop after " << i-1 << " frames elaborated." << std::endl;
+    cv::Mat frame_i;
     capture >> frame_i;
     CV_Assert(frame_i.empty()); //check that video was actually finished
 
     capture.release();
     writer.release();
-    std::cout << "Video saved at " << out_path << "." << std::endl;
-
-    std::cout << "---METRICS-------------" << std::endl;
     double mAP = compute_mAP(this->ffirst_ret_bb,this->ffirst_bb) + compute_mAP(this->flast_ret_bb,this->flast_bb);
-    std::cout << "mAP = " << mAP/2.0 << std::endl;
+    this->mAP = mAP/2.0;
     
     std::vector<std::pair<cv::Mat, cv::Mat>> segmasks;
 
@@ -200,8 +175,247 @@ void videoHandler::process_video(int MIDSTEP_flag){
     segmasks.push_back(pairfirst);
     segmasks.push_back(pairlast);
     
-    double mIoU = compute_mIoU(segmasks,6);
-    std::cout << "mIoU = " << mIoU << std::endl;
+    this->mIoU = compute_mIoU(segmasks,6);
+
+    if (options.verbose){
+        std::cout << "Video saved at " << out_path << "." << std::endl;
+        std::cout << "---METRICS-------------" << std::endl;
+        std::cout << "mAP = " << this->mAP << std::endl;
+        std::cout << "mIoU = " << this->mIoU << std::endl;
+    }
+}
+
+int videoHandler::run_sequential(cv::VideoCapture& capture, cv::VideoWriter& writer, int tot_frames, const processingOptions& options){
+    frameHandler frame_handler = frameHandler(options);
+    frame_handler.reserve_history(tot_frames);
+    framePacket packet;
+    packet.skipped = 0;
+
+    int i = 1;
+    int stride = std::max(1, options.frame_stride);
+    int analyzed = 0;
+    while (i <= tot_frames) {
+        {
+            TIME_STAGE(frame_handler.stage_profiler(), STAGE_DECODE);
+            capture >> packet.frame;
+        }
+        packet.index = i;
+        if (options.verbose){
+            std::cout << "frame " << i << "/" << tot_frames << std::endl;}
+
+        this->analyze_frame(frame_handler, packet, tot_frames, options);
+        this->render_frame(frame_handler, packet);
+        this->collect_frame(frame_handler, writer, packet, tot_frames);
+        analyzed++;
+
+        // Temporal stride: denser while the balls move fast, never past the last frame
+        int next = i+1;
+        if (options.frame_stride > 1 && i < tot_frames){
+            double displacement = frame_handler.max_displacement();
+            if (displacement > options.stride_displacement){
+                stride = std::max(1, stride/2);}
+            else if (displacement < options.stride_displacement/2){
+                stride = std::min(options.frame_stride, stride*2);}
+            next = std::min(i+stride, tot_frames);
+        }
+
+        // Skipped frames: grabbed only (no conversion), the last output frame stands for them
+        for (int k = i+1; k < next; ++k){
+            {
+                TIME_STAGE(frame_handler.stage_profiler(), STAGE_GRAB);
+                capture.grab();
+            }
+            TIME_STAGE(frame_handler.stage_profiler(), STAGE_ENCODE);
+            writer.write(packet.ret_frame);
+        }
+        frame_handler.skip_frames(next-i-1);
+        packet.skipped = next-i-1;
+        i = next;
+    }
+
+    if (options.verbose && options.frame_stride > 1){
+        std::cout << "Temporal stride: " << analyzed << "/" << tot_frames << " frames analyzed" << std::endl;}
+
+    this->finish_run(frame_handler, tot_frames, options);
+    return i-1;
+}
+
+int videoHandler::run_pipelined(cv::VideoCapture& capture, cv::VideoWriter& writer, int tot_frames, const processingOptions& options){
+    frameHandler frame_handler = frameHandler(options);
+    frame_handler.reserve_history(tot_frames);
+
+    // Frame buffers are allocated once and recycled: the queues only move slot indexes around.
+    // Enough slots to fill every queue plus the one each stage is working on.
+    size_t capacity = std::max(1, options.queue_capacity);
+    std::vector<framePacket> slots(3 * capacity + 4);
+
+    spscQueue<int> free_slots(slots.size());
+    spscQueue<int> decoded(capacity);
+    spscQueue<int> analyzed(capacity);
+    spscQueue<int> rendered(capacity);
+    for (size_t s=0; s<slots.size(); ++s){
+        free_slots.push(static_cast<int>(s));}
+
+    const int END = -1;    //sentinel closing the stream
+
+    // Decoder stage
+    std::thread decoder([&]() {
+        for (int i=1; i<=tot_frames; ++i){
+            int s;
+            free_slots.pop(s);
+            {
+                TIME_STAGE(frame_handler.stage_profiler(), STAGE_DECODE);
+                capture >> slots[s].frame;
+            }
+            slots[s].index = i;
+            slots[s].skipped = 0;
+            decoded.push(s);
+        }
+        decoded.push(END);
+    });
+
+    // Analysis stage: detection and tracking, strictly in frame order
+    std::thread analyzer([&]() {
+        int s;
+        decoded.pop(s);
+        while (s != END){
+            this->analyze_frame(frame_handler, slots[s], tot_frames, options);
+            analyzed.push(s);
+            decoded.pop(s);
+        }
+        analyzed.push(END);
+    });
+
+    // Render stage: borders and minimap from the snapshot taken by the analysis
+    std::thread renderer([&]() {
+        int s;
+        analyzed.pop(s);
+        while (s != END){
+            this->render_frame(frame_handler, slots[s]);
+            rendered.push(s);
+            analyzed.pop(s);
+        }
+        rendered.push(END);
+    });
+
+    // Encoder stage runs on the calling thread, so that the sink (HighGUI) stays on it
+    int frames_done = 0;
+    int s;
+    rendered.pop(s);
+    while (s != END){
+        if (options.verbose){
+            std::cout << "frame " << slots[s].index << "/" << tot_frames << std::endl;}
+        this->collect_frame(frame_handler, writer, slots[s], tot_frames);
+        frames_done++;
+        free_slots.push(s);
+        rendered.pop(s);
+    }
+
+    decoder.join();
+    analyzer.join();
+    renderer.join();
+
+    if (options.verbose){
+        std::cout << "---PIPELINE QUEUES-----" << std::endl;
+        decoded.print_stats("decode -> analyze");
+        analyzed.print_stats("analyze -> render");
+        rendered.print_stats("render -> encode");
+        free_slots.print_stats("encode -> decode (free buffers)");
+    }
+    this->finish_run(frame_handler, tot_frames, options);
+
+    return frames_done;
+}
+
+void videoHandler::analyze_frame(frameHandler& frame_handler, framePacket& packet, int tot_frames, const processingOptions& options){
+    int i = packet.index;
+    const cv::Mat& frame_i = packet.frame;
+
+    // Elaborate video - call frameHandler --------------------
+    frame_handler.begin_frame(frame_i);
+
+    // Event-driven mode: detection again once the balls are at rest after a shot
+    bool at_rest = false;
+    if (options.shot_events){
+        at_rest = frame_handler.detect_rest(frame_i, i) && i>1 && i<tot_frames;}
+
+    // Periodic re-detection: every `redetect_interval` frames the trackers are checked against a new detection
+    // (with a temporal stride: on the first analyzed frame at or after every K-th one)
+    bool periodic = options.redetect_interval > 0 && i>1 && i<tot_frames && (i-1)/options.redetect_interval != (i-2-packet.skipped)/options.redetect_interval;
+
+    // Runs only for first frame, at rest states, periodic re-detections, or every if MIDSTEP_flag==true
+    packet.detected = (i==1 || i==tot_frames || options.MIDSTEP_flag || at_rest || periodic);
+    if (packet.detected){
+        frame_handler.detect_table();
+        if (i==1){
+            frame_handler.save_table_corners();}
+        frame_handler.detect_balls();
+        if (i==1){
+            frame_handler.initializeTrackers(frame_i);
+            frame_handler.save_ids();
+        }
+        else if (at_rest || periodic){
+            frame_handler.resync_trackers(frame_i, at_rest);}
+        packet.bbox_data = frame_handler.bbox_data;
+        packet.classification_res = frame_handler.classification_res;
+    }
+
+    // Runs for every frame
+    frame_handler.updateTrackers(frame_i);
+    frame_handler.save_state(packet.state);
+}
+
+void videoHandler::finish_run(frameHandler& frame_handler, int tot_frames, const processingOptions& options){
+    if (options.verbose){
+        frame_handler.print_tracker_stats();}
+    frame_handler.save_trajectories("../build/output/" + this->folder_name + "_trajectories.txt");
+
+    // Latency of every stage over the whole run (all the threads of the pipeline included)
+    if (options.verbose){
+        frame_handler.stage_profiler()->print_report();}
+    if (options.timings_json){
+        frame_handler.stage_profiler()->save_json("../build/output/" + this->folder_name + "_timings.json");}
+
+    if (options.shot_events){
+        const shotSegmenter& shots = frame_handler.finish_shots(tot_frames);
+        if (options.verbose){
+            shots.print_timeline();}
+        shots.save_timeline("../build/output/" + this->folder_name + "_shots.txt");
+    }
+}
+
+void videoHandler::render_frame(frameHandler& frame_handler, framePacket& packet){
+    frame_handler.draw_frame(packet.frame, packet.w_borders_on, packet.state);
+    packet.ret_frame = frame_handler.project(packet.w_borders_on, packet.state);
+}
+
+void videoHandler::collect_frame(frameHandler& frame_handler, cv::VideoWriter& writer, framePacket& packet, int tot_frames){
+    int i = packet.index;
+
+    if (this->sink != nullptr){
+        this->sink->show_frame(packet.ret_frame);}
+    
+    //SAVES ONLY FIRST AND LAST
+    if (packet.detected){
+        if (i==1){
+            this->ffirst_ret_bb = packet.bbox_data;
+            this->ffirst_ret_mask = packet.classification_res;
+            
+        }
+        else if(i==tot_frames){
+            this->flast_ret_bb = packet.bbox_data;
+            this->flast_ret_mask = packet.classification_res;
+        }
+
+        // Midsteps are rendered only if someone is watching them
+        if (this->sink != nullptr){
+            this->sink->show_midstep(this->plot_bb(packet.w_borders_on, packet.bbox_data), this->displayMask(packet.classification_res), i==1 || i==tot_frames);}
+    }
+
+    //-------------------------------------------------------
+    
+    TIME_STAGE(frame_handler.stage_profiler(), STAGE_ENCODE);
+    writer.write(packet.ret_frame);
 }
 
 //-----------------------------------------------------------
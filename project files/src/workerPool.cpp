@@ -0,0 +1,107 @@
+/*
+    AUTHOR: agent
+    DATE: 2026-10-17
+    FILE: workerPool.cpp
+    DESCRIPTION: Implementation of the pool of persistent worker threads.
+
+    CLASSES:
+    - class workerPool: Fixed set of threads that execute the iterations of a parallel loop.
+
+    METHODS:
+    - workerPool(int num_threads): Starts the workers. With 0 the pool is sized to the machine (hardware threads).
+    - ~workerPool(): Wakes up and joins all the workers.
+    - int size() const: Number of threads taking part in a loop, calling thread included.
+    - void parallel_for(...): Runs body(0..count-1) on the pool and returns when every iteration is done.
+    - void worker_loop(): Body of every worker, waits for a new loop and takes part in it.
+    - void run_iterations(): Takes iterations from the shared counter until none is left.
+*/
+
+#include "workerPool.h"
+
+workerPool::workerPool(int num_threads){
+    this->body = nullptr;
+    this->count = 0;
+    this->next = 0;
+    this->generation = 0;
+    this->busy = 0;
+    this->stopping = false;
+
+    if (num_threads <= 0){
+        num_threads = std::max(1u, std::thread::hardware_concurrency());}
+
+    // The calling thread is the first worker
+    for (int i=1; i<num_threads; ++i){
+        this->workers.push_back(std::thread(&workerPool::worker_loop, this));}
+}
+
+workerPool::~workerPool(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->job_ready.notify_all();
+    for (std::thread& worker : this->workers){
+        worker.join();}
+}
+
+int workerPool::size() const{
+    return static_cast<int>(this->workers.size()) + 1;
+}
+
+void workerPool::parallel_for(int count, const std::function<void(int)>& body){
+    if (count <= 0){
+        return;}
+
+    // Nothing to share: run inline
+    if (this->workers.empty() || count == 1){
+        for (int i=0; i<count; ++i){
+            body(i);}
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->body = &body;
+        this->count = count;
+        this->next = 0;
+        this->busy = static_cast<int>(this->workers.size());
+        this->generation++;
+    }
+    this->job_ready.notify_all();
+
+    this->run_iterations();
+
+    // Wait for the workers to leave the loop before the body goes out of scope
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->job_done.wait(lock, [this]() { return this->busy == 0; });
+    this->body = nullptr;
+}
+
+void workerPool::worker_loop(){
+    int seen_generation = 0;
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_ready.wait(lock, [&]() { return this->stopping || this->generation != seen_generation; });
+            if (this->stopping){
+                return;}
+            seen_generation = this->generation;
+        }
+
+        this->run_iterations();
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->busy--;
+        }
+        this->job_done.notify_one();
+    }
+}
+
+void workerPool::run_iterations(){
+    int i = this->next.fetch_add(1);
+    while (i < this->count){
+        (*this->body)(i);
+        i = this->next.fetch_add(1);
+    }
+}